@@ -67,7 +67,9 @@ ELSE()
 ENDIF(CHANGE_G3LOG_DEBUG_TO_DBUG)
 
 
-# -DG3_DYNAMIC_MAX_MESSAGE_SIZE   : use dynamic memory for final_message in logcapture.cpp
+# -DG3_DYNAMIC_MAX_MESSAGE_SIZE   : limit the size of the printf-like LOGF messages, by default 2048 bytes,
+# changeable at runtime with g3::only_change_at_initialization::setMaxMessageSize.
+# Without it the LOGF messages have no size limit
 option (USE_G3_DYNAMIC_MAX_MESSAGE_SIZE
        "Use dynamic memory for message buffer during log capturing" OFF)
 IF(USE_G3_DYNAMIC_MAX_MESSAGE_SIZE)
@@ -89,6 +91,163 @@ ELSE()
 ENDIF(G3_LOG_FULL_FILENAME)
 
 
+# -DUSE_G3_INPLACE_CAPTURE=ON : the LogMessage only refers to the __FILE__ and function
+# name literals of the LOG call instead of copying them. Saves an allocation and copy per
+# log entry but is NOT safe if a dynamically loaded library (dlopen/LoadLibrary) that logs
+# can be unloaded while its messages are still queued to the background worker
+option (USE_G3_INPLACE_CAPTURE
+       "Refer to the file and function literals instead of copying them into each LogMessage" OFF)
+IF(USE_G3_INPLACE_CAPTURE)
+   LIST(APPEND G3_DEFINITIONS G3_LOG_INPLACE_CAPTURE)
+   message( STATUS "-DUSE_G3_INPLACE_CAPTURE=ON		File and function literals are not copied" )
+ELSE()
+   message( STATUS "-DUSE_G3_INPLACE_CAPTURE=OFF" )
+ENDIF(USE_G3_INPLACE_CAPTURE)
+
+
+# -DUSE_G3_DEFERRED_FORMATTING=ON : integer and floating point values streamed with
+# LOG(level) << ... are not formatted by the logging thread. They are kept as raw bytes
+# and formatted to text by the background worker before the sinks receive the message.
+# Fatal levels (LOG(FATAL), CHECK) and the printf-like LOGF API are always formatted
+# directly
+option (USE_G3_DEFERRED_FORMATTING
+       "Format streamed numbers on the background worker instead of the logging thread" OFF)
+IF(USE_G3_DEFERRED_FORMATTING)
+   LIST(APPEND G3_DEFINITIONS G3_LOG_DEFERRED_FORMATTING)
+   message( STATUS "-DUSE_G3_DEFERRED_FORMATTING=ON		Numbers are formatted by the background worker" )
+ELSE()
+   message( STATUS "-DUSE_G3_DEFERRED_FORMATTING=OFF" )
+ENDIF(USE_G3_DEFERRED_FORMATTING)
+
+
+# -DUSE_G3_LOGMESSAGE_POOL=ON : the LogMessage objects of LOG calls are recycled. The sinks
+# give the messages they were sent back to a pool, with their allocated memory, instead of
+# deleting them. Threads that log often then stop allocating for the message.
+# See g3log/logmessagepool.hpp
+option (USE_G3_LOGMESSAGE_POOL
+       "Recycle LogMessage objects between the logging threads and the background worker" OFF)
+IF(USE_G3_LOGMESSAGE_POOL)
+   LIST(APPEND G3_DEFINITIONS G3_LOG_MESSAGE_POOL)
+   message( STATUS "-DUSE_G3_LOGMESSAGE_POOL=ON		LogMessage objects are recycled" )
+ELSE()
+   message( STATUS "-DUSE_G3_LOGMESSAGE_POOL=OFF" )
+ENDIF(USE_G3_LOGMESSAGE_POOL)
+
+
+# -DUSE_G3_LOG_STAGING=ON : the messages of a thread are collected in a staging area of
+# its own and handed to the background worker in batches: when a number of messages or bytes
+# is reached, every 10 ms, at thread exit, at shutdown and before a fatal message. One queue
+# hand-over then serves many messages. See g3log/logstaging.hpp for the thresholds
+option (USE_G3_LOG_STAGING
+       "Hand the log messages of a thread to the background worker in batches" OFF)
+IF(USE_G3_LOG_STAGING)
+   LIST(APPEND G3_DEFINITIONS G3_LOG_STAGING)
+   message( STATUS "-DUSE_G3_LOG_STAGING=ON		Log messages are handed over in batches" )
+ELSE()
+   message( STATUS "-DUSE_G3_LOG_STAGING=OFF" )
+ENDIF(USE_G3_LOG_STAGING)
+
+
+# -DUSE_G3_VMODULE=ON : the files that match a pattern can be given a minimum log level of
+# their own at runtime, e.g. g3::setVModule("net/*=DEBUG,storage/compaction.cpp=INFO").
+# Each LOG call site caches the rule of its file, a LOG call costs one more load and compare.
+# See g3log/vmodule.hpp
+option (USE_G3_VMODULE
+       "Per file minimum log levels, set at runtime with g3::setVModule" OFF)
+IF(USE_G3_VMODULE)
+   LIST(APPEND G3_DEFINITIONS G3_LOG_VMODULE)
+   message( STATUS "-DUSE_G3_VMODULE=ON		Per file log levels can be set" )
+ELSE()
+   message( STATUS "-DUSE_G3_VMODULE=OFF" )
+ENDIF(USE_G3_VMODULE)
+
+
+# -DG3_INLINE_MESSAGE_SIZE=256 : the message text of a LogMessage is kept inside the
+# LogMessage itself up to this many bytes (the terminating zero included). Only a longer
+# text is allocated on the heap. A larger value makes every LogMessage bigger
+SET(G3_INLINE_MESSAGE_SIZE 256 CACHE STRING
+    "Bytes of message text kept inline in the LogMessage before it is put on the heap")
+IF(NOT G3_INLINE_MESSAGE_SIZE MATCHES "^[0-9]+$" OR G3_INLINE_MESSAGE_SIZE LESS 1)
+   message( FATAL_ERROR "-DG3_INLINE_MESSAGE_SIZE=${G3_INLINE_MESSAGE_SIZE} must be a positive number" )
+ENDIF()
+LIST(APPEND G3_DEFINITIONS "G3_LOG_INLINE_MESSAGE_SIZE ${G3_INLINE_MESSAGE_SIZE}")
+message( STATUS "-DG3_INLINE_MESSAGE_SIZE=${G3_INLINE_MESSAGE_SIZE}\t\tBytes of message text kept inline" )
+
+
+# -DG3_PREINIT_MESSAGES=256 -DG3_PREINIT_BYTES=65536 : the messages logged before the first
+# g3::initializeLogging, e.g. by static initializers, are kept in a ring of G3_PREINIT_MESSAGES
+# messages with at most G3_PREINIT_BYTES bytes of message text. They are given to the LogWorker
+# when the logging is initialized, or written to stderr if the process exits before that.
+# See g3log/logpreinit.hpp
+SET(G3_PREINIT_MESSAGES 256 CACHE STRING
+    "Messages logged before g3::initializeLogging that are kept for the LogWorker")
+SET(G3_PREINIT_BYTES 65536 CACHE STRING
+    "Bytes of message text logged before g3::initializeLogging that are kept for the LogWorker")
+IF(NOT G3_PREINIT_MESSAGES MATCHES "^[0-9]+$" OR G3_PREINIT_MESSAGES LESS 1)
+   message( FATAL_ERROR "-DG3_PREINIT_MESSAGES=${G3_PREINIT_MESSAGES} must be a positive number" )
+ENDIF()
+IF(NOT G3_PREINIT_BYTES MATCHES "^[0-9]+$")
+   message( FATAL_ERROR "-DG3_PREINIT_BYTES=${G3_PREINIT_BYTES} must be a number" )
+ENDIF()
+LIST(APPEND G3_DEFINITIONS "G3_LOG_PREINIT_MESSAGES ${G3_PREINIT_MESSAGES}")
+LIST(APPEND G3_DEFINITIONS "G3_LOG_PREINIT_BYTES ${G3_PREINIT_BYTES}")
+message( STATUS "-DG3_PREINIT_MESSAGES=${G3_PREINIT_MESSAGES}\t\tMessages kept before initializeLogging" )
+message( STATUS "-DG3_PREINIT_BYTES=${G3_PREINIT_BYTES}\t\tBytes of message text kept before initializeLogging" )
+
+
+# -DG3_LOG_CLOCK=HIGH_RESOLUTION|COARSE|TSC : the clock that time stamps the log entries
+#   HIGH_RESOLUTION (default) : std::chrono::high_resolution_clock
+#   COARSE : Linux only, the kernel's coarse clock read without a system call. The
+#            resolution is the scheduler tick, 1-4 ms
+#   TSC    : the raw CPU counter (x86 rdtsc, ARM64 cntvct_el0). The background worker converts
+#            it to time with a mapping that it recalibrates every second. Needs an invariant TSC
+# See g3log/clock.hpp
+SET(G3_LOG_CLOCK "HIGH_RESOLUTION" CACHE STRING "The clock for the log entry time stamps: HIGH_RESOLUTION, COARSE or TSC")
+SET_PROPERTY(CACHE G3_LOG_CLOCK PROPERTY STRINGS HIGH_RESOLUTION COARSE TSC)
+IF(G3_LOG_CLOCK STREQUAL "COARSE")
+   LIST(APPEND G3_DEFINITIONS G3_LOG_CLOCK_COARSE)
+ELSEIF(G3_LOG_CLOCK STREQUAL "TSC")
+   LIST(APPEND G3_DEFINITIONS G3_LOG_CLOCK_TSC)
+ELSEIF(NOT G3_LOG_CLOCK STREQUAL "HIGH_RESOLUTION")
+   message( FATAL_ERROR "-DG3_LOG_CLOCK=${G3_LOG_CLOCK} must be one of HIGH_RESOLUTION, COARSE or TSC" )
+ENDIF()
+message( STATUS "-DG3_LOG_CLOCK=${G3_LOG_CLOCK}\t\tClock of the log entry time stamps" )
+
+
+# -DG3_LOGF_BACKEND=LIBC|TZ : the engine that formats the printf-like LOGF/CHECKF text
+#   LIBC (default) : the C library's vsnprintf
+#   TZ   : tz_vsnprintf of g3log/format_string.hpp. The same output as glibc for all C99
+#          conversions, without locale lookups. Compare the two with the
+#          g3log-performance-format_string benchmark (ADD_G3LOG_BENCH_PERFORMANCE=ON)
+SET(G3_LOGF_BACKEND "LIBC" CACHE STRING "The engine that formats the LOGF text: LIBC or TZ")
+SET_PROPERTY(CACHE G3_LOGF_BACKEND PROPERTY STRINGS LIBC TZ)
+IF(G3_LOGF_BACKEND STREQUAL "TZ")
+   LIST(APPEND G3_DEFINITIONS G3_LOG_TZ_VSNPRINTF)
+ELSEIF(NOT G3_LOGF_BACKEND STREQUAL "LIBC")
+   message( FATAL_ERROR "-DG3_LOGF_BACKEND=${G3_LOGF_BACKEND} must be one of LIBC or TZ" )
+ENDIF()
+message( STATUS "-DG3_LOGF_BACKEND=${G3_LOGF_BACKEND}\t\tEngine of the LOGF formatting" )
+
+
+# -DG3_MIN_LOG_LEVEL=DEBUG|INFO|WARNING|FATAL : the lowest level that LOG calls are compiled
+# for. The LOG calls at G3LOG_DEBUG, INFO, WARNING and FATAL below it are discarded at compile
+# time: the streamed arguments are still type checked, but there is no code for them. DEBUG
+# (default) keeps all of them. CHECK calls and LOG calls at custom levels are always kept.
+# The debug only DLOG/DCHECK calls are discarded when NDEBUG is defined. See g3log/loglevels.hpp
+SET(G3_MIN_LOG_LEVEL "DEBUG" CACHE STRING "The lowest level that LOG calls are compiled for: DEBUG, INFO, WARNING or FATAL")
+SET_PROPERTY(CACHE G3_MIN_LOG_LEVEL PROPERTY STRINGS DEBUG INFO WARNING FATAL)
+IF(G3_MIN_LOG_LEVEL STREQUAL "INFO")
+   LIST(APPEND G3_DEFINITIONS "G3_LOG_MIN_LEVEL g3::kInfoValue")
+ELSEIF(G3_MIN_LOG_LEVEL STREQUAL "WARNING")
+   LIST(APPEND G3_DEFINITIONS "G3_LOG_MIN_LEVEL g3::kWarningValue")
+ELSEIF(G3_MIN_LOG_LEVEL STREQUAL "FATAL")
+   LIST(APPEND G3_DEFINITIONS "G3_LOG_MIN_LEVEL g3::kFatalValue")
+ELSEIF(NOT G3_MIN_LOG_LEVEL STREQUAL "DEBUG")
+   message( FATAL_ERROR "-DG3_MIN_LOG_LEVEL=${G3_MIN_LOG_LEVEL} must be one of DEBUG, INFO, WARNING or FATAL" )
+ENDIF()
+message( STATUS "-DG3_MIN_LOG_LEVEL=${G3_MIN_LOG_LEVEL}\t\tLowest level LOG calls are compiled for" )
+
+
 # -DENABLE_FATAL_SIGNALHANDLING=ON   : default change the
 # By default fatal signal handling is enabled. You can disable it with this option
 # enumerated in src/stacktrace_windows.cpp 
@@ -0,0 +1,76 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/callsite.hpp"
+
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <dlfcn.h>
+#include <mach-o/dyld.h>
+#elif defined(__linux__) || defined(__FreeBSD__)
+#include <link.h>
+#endif
+
+#include <cstdint>
+
+namespace {
+#if !(defined(WIN32) || defined(_WIN32) || defined(__WIN32__)) && !defined(__APPLE__) && (defined(__linux__) || defined(__FreeBSD__))
+   struct Lookup {
+      uintptr_t address;
+      bool found;
+   };
+
+   // The first object reported by dl_iterate_phdr is always the executable
+   int inFirstObject(struct dl_phdr_info* info, size_t, void* data) {
+      auto lookup = static_cast<Lookup*>(data);
+      for (int i = 0; i < info->dlpi_phnum; ++i) {
+         const auto& segment = info->dlpi_phdr[i];
+         if (PT_LOAD != segment.p_type) {
+            continue;
+         }
+         const uintptr_t start = info->dlpi_addr + segment.p_vaddr;
+         if (lookup->address >= start && lookup->address < start + segment.p_memsz) {
+            lookup->found = true;
+            break;
+         }
+      }
+      return 1; // stop after the executable
+   }
+#endif
+} // anonymous
+
+
+namespace g3 {
+   namespace internal {
+      bool isInExecutable(const void* address) {
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+         HMODULE module = nullptr;
+         const DWORD flags = GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT;
+         if (!GetModuleHandleExA(flags, static_cast<LPCSTR>(address), &module)) {
+            return false;
+         }
+         return module == GetModuleHandleA(nullptr);
+#elif defined(__APPLE__)
+         Dl_info info;
+         if (0 == dladdr(address, &info)) {
+            return false;
+         }
+         return info.dli_fbase == static_cast<const void*>(_dyld_get_image_header(0));
+#elif defined(__linux__) || defined(__FreeBSD__)
+         Lookup lookup {reinterpret_cast<uintptr_t>(address), false};
+         dl_iterate_phdr(inFirstObject, &lookup);
+         return lookup.found;
+#else
+         // unknown platform: copying is always safe
+         (void)address;
+         return false;
+#endif
+      }
+   } // internal
+} // g3
@@ -0,0 +1,141 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/clock.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace {
+   using namespace std::chrono;
+   constexpr bool kSameClocks = std::is_same<high_resolution_clock, system_clock>::value;
+
+   int64_t nowNanoseconds() {
+      return duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
+   }
+
+   // a TSC reading and the high_resolution_clock at the same moment, as near as can be
+   struct Sample {
+      uint64_t ticks;
+      int64_t ns;
+
+      static Sample take() {
+         const int64_t before = nowNanoseconds();
+         const uint64_t ticks = g3::internal::cpuTicks();
+         const int64_t after = nowNanoseconds();
+         return {ticks, before + (after - before) / 2};
+      }
+   };
+
+
+   /** The ticks are converted relative to the latest sample (the anchor). The rate is
+    * measured from the first sample, so it gets more precise the longer the process runs */
+   struct Calibration {
+      std::mutex mutex;
+      Sample first;
+      Sample anchor;
+      double ns_per_tick = 1.0;
+      std::atomic<int64_t> system_offset_ns {0};
+      std::atomic<int64_t> calibrated_ns {0};
+
+      Calibration() {
+         first = Sample::take();
+         // a first estimate of the rate, refined at every recalibration
+         const int64_t until = first.ns + duration_cast<nanoseconds>(milliseconds(2)).count();
+         do {
+            anchor = Sample::take();
+         } while (anchor.ns < until);
+         updateRate();
+         measureSystemOffset();
+         calibrated_ns.store(anchor.ns, std::memory_order_relaxed);
+      }
+
+      void updateRate() {
+         if (anchor.ticks > first.ticks) {
+            ns_per_tick = static_cast<double>(anchor.ns - first.ns) / static_cast<double>(anchor.ticks - first.ticks);
+         }
+      }
+
+      // a real clock difference only if the high_resolution_clock is not the system_clock,
+      // e.g. a steady clock, which drifts from the wall clock when NTP adjusts it
+      void measureSystemOffset() {
+         if (kSameClocks) {
+            return;
+         }
+         const int64_t before = nowNanoseconds();
+         const int64_t system = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+         const int64_t after = nowNanoseconds();
+         system_offset_ns.store(system - (before + (after - before) / 2), std::memory_order_relaxed);
+      }
+
+      void recalibrate(int64_t now_ns) {
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            anchor = Sample::take();
+            updateRate();
+         }
+         measureSystemOffset();
+         calibrated_ns.store(now_ns, std::memory_order_relaxed);
+      }
+   };
+
+   // Never destroyed: messages can be converted by threads that log after main
+   Calibration& calibration() {
+      static Calibration* instance = new Calibration;
+      return *instance;
+   }
+} // anonymous
+
+
+
+namespace g3 {
+   namespace internal {
+      high_resolution_time_point ticksToTimePoint(uint64_t ticks) {
+         auto& current = calibration();
+         int64_t ns = 0;
+         {
+            std::lock_guard<std::mutex> lock(current.mutex);
+            // signed: a message can be older than the anchor
+            const auto elapsed = static_cast<int64_t>(ticks - current.anchor.ticks);
+            ns = current.anchor.ns + static_cast<int64_t>(static_cast<double>(elapsed) * current.ns_per_tick);
+         }
+         return high_resolution_time_point(duration_cast<high_resolution_clock::duration>(nanoseconds(ns)));
+      }
+
+
+      nanoseconds systemClockOffset() {
+         if (kSameClocks) {
+            return nanoseconds(0);
+         }
+         return nanoseconds(calibration().system_offset_ns.load(std::memory_order_relaxed));
+      }
+
+
+      void refreshClockCalibration() {
+#if !defined(G3_LOG_CLOCK_TSC)
+         if (kSameClocks) {
+            return; // nothing to calibrate
+         }
+#endif
+         auto& current = calibration();
+         const int64_t now = nowNanoseconds();
+         const int64_t interval = duration_cast<nanoseconds>(kClockCalibrationInterval).count();
+         if (now - current.calibrated_ns.load(std::memory_order_relaxed) >= interval) {
+            current.recalibrate(now);
+         }
+      }
+   } // internal
+
+
+   // The offset between the clocks is measured again every kClockCalibrationInterval by the
+   // LogWorker, so the wall clock time does not drift away over a long uptime
+   system_time_point to_system_time(const high_resolution_time_point& ts) {
+      const auto wall = ts.time_since_epoch() + internal::systemClockOffset();
+      return system_time_point(duration_cast<system_clock::duration>(wall));
+   }
+} // g3
@@ -1,12 +1,16 @@
-﻿#include <stdio.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h> // va_list and its operations
+#include <stddef.h> // ptrdiff_t
 #include <stdint.h> // various type definitions
 #include <sys/types.h>
 #include <ctype.h> // https://www.tutorialspoint.com/c_standard_library/ctype_h.htm
 #include <string.h>
 #include <math.h>
 #include <limits.h>
+#include <charconv>
+#include <string>
+#include <type_traits>
 //#include <endian.h> // __BYTE_ORDER, __LITTLE_ENDIAN　
 
 #include "g3log/format_string.hpp"
@@ -54,7 +58,6 @@ typedef int pid_t;
 // NGX_INT64_LEN == 20
 #define NGX_INT64_LEN          (sizeof("-9223372036854775808") - 1)
 
-#define abs(a)  ((a) < 0 ?  -(a) :(a))
 // #define is_digit(c) ((c) >= '0' && (c) <= '9')
 
 #define FLT_MAX_10_EXP     38
@@ -115,18 +118,44 @@ typedef struct outbuf_arg {
 //#define OK		0
 //#define ERROR		(-1)
 
-// to extend shorts, signed and unsigned, arg extraction methods are needed
+// the length modifiers of a conversion, e.g. %hhd, %zu, %Lf
+typedef enum
+{
+    LEN_DEFAULT,
+    LEN_HH,     // char
+    LEN_H,      // short
+    LEN_L,      // long
+    LEN_LL,     // long long
+    LEN_J,      // intmax_t
+    LEN_Z,      // size_t
+    LEN_T,      // ptrdiff_t
+    LEN_BIG_L   // long double
+} LENGTH_MODIFIER;
+
+typedef std::make_signed<size_t>::type      ssize_type;
+typedef std::make_unsigned<ptrdiff_t>::type uptrdiff_type;
+
+// to extend chars and shorts, signed and unsigned, arg extraction methods are needed.
+// They are promoted to int when passed through the ellipsis
 #define	SARG() \
-    ((doLongLongInt) ? (long long) va_arg(vaList, long long) : \
-    (doLongInt) ? (long long)(long)va_arg(vaList, long) : \
-    (doShortInt) ? (long long)(short)va_arg(vaList, long/*int*/) : \
-    (long long)(int) va_arg(vaList, long/*int*/))
+    ((lengthMod == LEN_LL) ? (long long) va_arg(vaList, long long) : \
+    (lengthMod == LEN_L) ? (long long) va_arg(vaList, long) : \
+    (lengthMod == LEN_J) ? (long long) va_arg(vaList, intmax_t) : \
+    (lengthMod == LEN_Z) ? (long long) va_arg(vaList, ssize_type) : \
+    (lengthMod == LEN_T) ? (long long) va_arg(vaList, ptrdiff_t) : \
+    (lengthMod == LEN_H) ? (long long)(short) va_arg(vaList, int) : \
+    (lengthMod == LEN_HH) ? (long long)(signed char) va_arg(vaList, int) : \
+    (long long) va_arg(vaList, int))
 
 #define	UARG() \
-    ((doLongLongInt) ? (unsigned long long) va_arg(vaList, unsigned long long) : \
-    (doLongInt) ? (unsigned long long)(ulong_t)va_arg(vaList, ulong_t): \
-    (doShortInt) ? (unsigned long long)(ushort_t)va_arg(vaList, ulong_t/*int*/): \
-    (unsigned long long)(uint_t) va_arg(vaList, ulong_t/*uint_t*/))
+    ((lengthMod == LEN_LL) ? (unsigned long long) va_arg(vaList, unsigned long long) : \
+    (lengthMod == LEN_L) ? (unsigned long long) va_arg(vaList, ulong_t) : \
+    (lengthMod == LEN_J) ? (unsigned long long) va_arg(vaList, uintmax_t) : \
+    (lengthMod == LEN_Z) ? (unsigned long long) va_arg(vaList, size_t) : \
+    (lengthMod == LEN_T) ? (unsigned long long) va_arg(vaList, uptrdiff_type) : \
+    (lengthMod == LEN_H) ? (unsigned long long)(ushort_t) va_arg(vaList, uint_t) : \
+    (lengthMod == LEN_HH) ? (unsigned long long)(uchar_t) va_arg(vaList, uint_t) : \
+    (unsigned long long) va_arg(vaList, uint_t))
 
 #define	PAD(howmany, with) \
 { \
@@ -144,12 +173,14 @@ typedef struct outbuf_arg {
 
 // The fieldSzIncludeSign indicates whether the sign should be included
 // in the precision of a number.
-bool fieldSzIncludeSign = /*TRUE*/true;
+static const bool fieldSzIncludeSign = /*TRUE*/true;
 
 static const char* blanks = "                ";
 static const char* zeroes = "0000000000000000";
 
 
+// the cvt helpers are the fallback for a compiler without std::to_chars for double
+#if !defined(__cpp_lib_to_chars)
 /******************************************************************************
 *
 * roundCvt - helper function for fioFormat
@@ -578,6 +609,114 @@ cvt(
 }
 
 
+#endif // !__cpp_lib_to_chars
+
+
+#if defined(__cpp_lib_to_chars)
+/******************************************************************************
+*
+* floatCvt - helper function for fioFormat
+*
+* Converts the magnitude of [number] for %[aAeEfFgG] with std::to_chars, which
+* gives the exact decimal expansion rounded half to even, just as the C library
+* does. The sign is left to the caller.
+*
+* RETURNS: the length of the text at [startp], or 0 if it did not fit
+*/
+
+static size_t
+floatCvt(
+    double number,
+    int    prec,        // precision, -1 only for the shortest exact %a
+    bool   doAlt,       // '#': always a decimal point, keep the trailing zeroes of %g
+    int    fmtch,
+    char*  startp,
+    char*  endp
+)
+{
+    const double magnitude = fabs(number);
+    const bool upper = (isupper(fmtch) != 0);
+    std::to_chars_result result;
+    char* p;
+    char* exponent;
+
+    if (isinf(magnitude) || isnan(magnitude))
+    {
+        if (endp - startp < 3)
+            return 0;
+        memcpy(startp, isinf(magnitude) ? (upper ? "INF" : "inf") : (upper ? "NAN" : "nan"), 3);
+        return 3;
+    }
+
+    switch (tolower(fmtch))
+    {
+    case 'f':
+        result = std::to_chars(startp, endp, magnitude, std::chars_format::fixed, prec);
+        break;
+
+    case 'e':
+        result = std::to_chars(startp, endp, magnitude, std::chars_format::scientific, prec);
+        break;
+
+    case 'a':
+        result = (prec < 0) ? std::to_chars(startp, endp, magnitude, std::chars_format::hex)
+                            : std::to_chars(startp, endp, magnitude, std::chars_format::hex, prec);
+        break;
+
+    default: // 'g'
+        if (prec == 0)
+            prec = 1;
+        if (!doAlt)
+        {
+            result = std::to_chars(startp, endp, magnitude, std::chars_format::general, prec);
+            break;
+        }
+
+        // to_chars drops the trailing zeroes, which '#' keeps: pick the style as %g would.
+        // Fixed if the exponent X of the 'e' style is -4 <= X < precision
+        result = std::to_chars(startp, endp, magnitude, std::chars_format::scientific, prec - 1);
+        if (result.ec != std::errc())
+            return 0;
+        exponent = (char*)memchr(startp, 'e', (size_t)(result.ptr - startp));
+        {
+            int exp = 0;
+            const bool negative = (exponent[1] == '-');
+            for (p = exponent + 2; p < result.ptr; ++p)
+                exp = 10 * exp + to_digit(*p);
+            if (negative)
+                exp = -exp;
+            if ((exp < prec) && (exp >= -4))
+                result = std::to_chars(startp, endp, magnitude, std::chars_format::fixed, prec - 1 - exp);
+        }
+        break;
+    }
+
+    if (result.ec != std::errc())
+        return 0;
+    p = result.ptr;
+
+    // '#': a decimal point even without digits after it, e.g. "3." or "3.e+00"
+    if (doAlt && (memchr(startp, '.', (size_t)(p - startp)) == NULL))
+    {
+        if (p >= endp)
+            return 0;
+        for (exponent = startp; (exponent < p) && (*exponent != 'e') && (*exponent != 'p'); ++exponent)
+            ;
+        memmove(exponent + 1, exponent, (size_t)(p - exponent));
+        *exponent = '.';
+        ++p;
+    }
+
+    if (upper)
+    {
+        for (char* c = startp; c < p; ++c)
+            *c = (char)toupper(*c);
+    }
+    return (size_t)(p - startp);
+}
+#endif
+
+
 /******************************************************************************
  *
  * fioBufPut - put characters in a buffer
@@ -656,7 +795,6 @@ fioFormat(
           ulongLongVal; // unsigned 64 bit arguments %[diouxX]
 
     int     prec;       // precision from format (e.g. %.3d), or -1
-    int	    oldprec;	// old precision from format (e.g. %.3d), or -1
 
     int	    dprec;	    // a copy of prec if [diouxX], 0 otherwise
     int	    fpprec;	    // `extra' floating precision in [eEfgG]
@@ -664,22 +802,21 @@ fioFormat(
     int	    fieldsz;	// field size expanded by sign, etc
     int	    realsz;	    // field size expanded by dprec
 
-    char    FMT[64];	// To collect fmt info
-    char*   Collect;	// char pointer to FMT
-
-    bool    doLongInt;  // long integer
-    bool    doLongLongInt;  // long long integer - 64 bit
-    bool    doShortInt;	// short integer
+    LENGTH_MODIFIER lengthMod;  // hh, h, l, ll, j, z, t or L
     bool    doAlt;      // alternate form
     bool    doLAdjust;	// left adjustment
     bool    doZeroPad;	// zero (as opposed to blank) pad
     bool    doHexPrefix; // add 0x or 0X prefix
 
     double  dbl;
-
+#if !defined(__cpp_lib_to_chars)
+    int	    oldprec;	// old precision from format (e.g. %.3d), or -1
     bool    doSign;     // change sign to '-'
+#endif
 
-    char    buf[BUF];	// space for %c, %[diouxX], %[eEfgG]
+
+    char    buf[BUF];	// space for %c, %[diouxX], %[aAeEfFgG]
+    std::string wideBuf; // space for %[aAeEfFgG] with a large precision
     char    ox[4];		// space for 0x hex-prefix
     const char* xdigs = NULL;   // digits for [xX] conversion
     int     ret = 0;    // return value accumulator
@@ -704,33 +841,24 @@ fioFormat(
 
         fmt++;   // *fmt == '\0' fmt++ skips over '%'
 
-        *FMT = /*EOS*/'\0';  // char FMT[64];
-        Collect = FMT;
-
-        doLongInt = false;	// long integer
-        doLongLongInt = false;	// 64 bit integer
-        doShortInt = false;	 // short integer
+        lengthMod = LEN_DEFAULT;
         doAlt = false;	// alternate form
         doLAdjust = false;	// left adjustment
         doZeroPad = false;	// zero (as opposed to blank) pad
         doHexPrefix = false;  // add 0x or 0X prefix
 
-        doSign = false;	// change sign to '-'
 
         dprec = 0;
         fpprec = 0;
         width = 0;
         prec = -1;
-        oldprec = -1;
 
         dbl = 0.0;
 
         sign = /*EOS*/'\0';
 
-#define get_CHAR  (ch = *(Collect++) = *(fmt++))
-        // char  FMT[64];   // To collect fmt info
-        // char* Collect;	// char pointer to FMT
-        // Collect = FMT;
+// the specifier is not collected: a copy in a fixed buffer overflowed on long specifiers
+#define get_CHAR  (ch = *(fmt++))
 
     rflag:
         get_CHAR;
@@ -815,22 +943,47 @@ fioFormat(
             goto reswitch;
 
         case 'h':
-            doShortInt = true;
-            goto rflag;
+            get_CHAR;
+            if (ch == 'h')
+            {
+                lengthMod = LEN_HH;
+                goto rflag;
+            }
+            else
+            {
+                lengthMod = LEN_H;
+                goto reswitch;
+            }
 
         case 'l':
             get_CHAR;
             if (ch == 'l')
             {
-                doLongLongInt = true;
+                lengthMod = LEN_LL;
                 goto rflag;
             }
             else
             {
-                doLongInt = true;
+                lengthMod = LEN_L;
                 goto reswitch;
             }
 
+        case 'j':
+            lengthMod = LEN_J;
+            goto rflag;
+
+        case 'z':
+            lengthMod = LEN_Z;
+            goto rflag;
+
+        case 't':
+            lengthMod = LEN_T;
+            goto rflag;
+
+        case 'L':
+            lengthMod = LEN_BIG_L;
+            goto rflag;
+
         case 'c':
             *(cp = buf) = (char)va_arg(vaList, int);
             size = 1;
@@ -839,7 +992,7 @@ fioFormat(
             break;
 
         case 'D':
-            doLongInt = true;			// FALLTHROUGH
+            lengthMod = LEN_L;			// FALLTHROUGH
 
         case 'd':
         case 'i':
@@ -847,7 +1000,7 @@ fioFormat(
 
             if ((long long)ulongLongVal < 0)
             {
-                ulongLongVal = -(long long)ulongLongVal;
+                ulongLongVal = 0ULL - ulongLongVal; // also right for LLONG_MIN
                 sign = '-';
             }
             base = DEC__;
@@ -858,18 +1011,21 @@ fioFormat(
             // the number of characters written to the output stream
             // so far by this call is written. No argument is converted.
             // ret is int, so effectively %lln = %ln
-            if (doLongLongInt)
-                *va_arg(vaList, long long*) = (long long)ret;
-            else if (doLongInt)
-                *va_arg(vaList, long*) = (long)ret;
-            else if (doShortInt)
-                *va_arg(vaList, short*) = (short)ret;
-            else
-                *va_arg(vaList, int*) = (int)ret;
+            switch (lengthMod)
+            {
+            case LEN_LL: *va_arg(vaList, long long*) = (long long)ret; break;
+            case LEN_L:  *va_arg(vaList, long*) = (long)ret; break;
+            case LEN_J:  *va_arg(vaList, intmax_t*) = (intmax_t)ret; break;
+            case LEN_Z:  *va_arg(vaList, ssize_type*) = (ssize_type)ret; break;
+            case LEN_T:  *va_arg(vaList, ptrdiff_t*) = (ptrdiff_t)ret; break;
+            case LEN_H:  *va_arg(vaList, short*) = (short)ret; break;
+            case LEN_HH: *va_arg(vaList, signed char*) = (signed char)ret; break;
+            default:     *va_arg(vaList, int*) = (int)ret; break;
+            }
             continue;  // no output
 
         case 'O':
-            doLongInt = true;    // FALLTHROUGH
+            lengthMod = LEN_L;    // FALLTHROUGH
 
         case 'o':
             ulongLongVal = UARG();
@@ -882,7 +1038,7 @@ fioFormat(
 
             if ((long long)ulongLongVal < 0)
             {
-                ulongLongVal = -(long long)ulongLongVal;
+                ulongLongVal = 0ULL - ulongLongVal; // also right for LLONG_MIN
                 sign = '-';
             }
             base = DEC__;
@@ -892,8 +1048,18 @@ fioFormat(
             // The argument shall be a pointer to void. The value of the 
             // pointer is converted to a sequence of printable characters,
             // in an implementation defined manner. -- ANSI X3J11
-            ulongLongVal = (unsigned long long) (unsigned long)
-                va_arg(vaList, void*);  // NOSTRICT
+            ulongLongVal = (unsigned long long) (uintptr_t)
+                va_arg(vaList, void*);  // NOSTRICT, uintptr_t: long is 32 bit on Win64
+#if defined(__GLIBC__)
+            if (ulongLongVal == 0)
+            {
+                cp = (char*)"(nil)";  // as glibc shows it
+                size = 5;
+                sign = /*EOS*/'\0';
+                doZeroPad = false;
+                break;
+            }
+#endif
             base = HEX__;
             xdigs = "0123456789abcdef";
             doHexPrefix = true;
@@ -935,7 +1101,7 @@ fioFormat(
             break;
 
         case 'U':
-            doLongInt = true;   // FALLTHROUGH
+            lengthMod = LEN_L;   // FALLTHROUGH
 
         case 'u':
             ulongLongVal = UARG();
@@ -1018,18 +1184,54 @@ fioFormat(
                     goto skipsize;
                 }
             }
+            else if ((base == OCT__) && doAlt)
+                *(--cp) = '0';  // '#' makes the first octal digit a zero, even for %#.0o
 
-            // size == 0 if ulongLongVal == 0 and prec == 0 
+            // size == 0 if ulongLongVal == 0 and prec == 0, except for %#.0o 
             size = (size_t)(buf + BUF - cp);
 
         skipsize:
             break;
 
-        case 'L':
-            // NOT IMPLEMENTED
-            goto rflag;
-
         ///////////////////////////// FLOAT FORMAT ////////////////////////////
+#if defined(__cpp_lib_to_chars)
+        case 'a':
+        case 'A':
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+            if ((prec == -1) && (ch != 'a') && (ch != 'A'))
+                prec = 6;		// ANSI default precision, %a defaults to exact
+
+            // %Lf: converted to double. Exact for every value a double can hold
+            dbl = (lengthMod == LEN_BIG_L) ? (double)va_arg(vaList, long double)
+                                           : va_arg(vaList, double);
+
+            cp = buf;
+            size = floatCvt(dbl, prec, doAlt, ch, buf, buf + sizeof(buf));
+            if (size == 0)
+            {
+                // large precision: room for all integer digits, the precision and an exponent
+                wideBuf.resize((size_t)DBL_MAX_10_EXP + (size_t)prec + 16);
+                cp = &wideBuf[0];
+                size = floatCvt(dbl, prec, doAlt, ch, cp, cp + wideBuf.size());
+            }
+
+            if (signbit(dbl))   // also -0.0 and -nan, as the C library does
+                sign = '-';
+
+            if (!isfinite(dbl))
+                doZeroPad = false;  // don't pad inf and nan with zeroes
+            else if ((ch == 'a') || (ch == 'A'))
+            {
+                doHexPrefix = true;
+                ch = (ch == 'a') ? 'x' : 'X';
+            }
+            break;
+#else
         case 'e':
         case 'E':
         case 'f':
@@ -1049,7 +1251,8 @@ fioFormat(
             cp = buf;		    // where to fill in result
             *cp = /*EOS*/'\0';	// EOS terminate just in case//////////////////
 
-            dbl = (double)va_arg(vaList, double);
+            dbl = (lengthMod == LEN_BIG_L) ? (double)va_arg(vaList, long double)
+                                           : va_arg(vaList, double);
             doSign = false;  // assume no sign needed
 
             if (/*isInf*/isinf(dbl))    // infinite?+
@@ -1099,6 +1302,7 @@ fioFormat(
                     cp++;
             }
             break;
+#endif
         ///////////////////////////// FLOAT FORMAT ////////////////////////////
 
         default:			// "%?" prints ?, unless ? is NULL
@@ -1127,14 +1331,14 @@ fioFormat(
         
         fieldsz = (int)((int)size + fpprec); // normally fpprec is 0
 
-        // sign != '\0' and doHexPrefix == true can not be met at the same time
+        // sign != '\0' and doHexPrefix == true only for a negative %a
         if (sign)
         {
             fieldsz++;
             if (fieldSzIncludeSign)
                 dprec++;
         }
-        else if (doHexPrefix)
+        if (doHexPrefix)
         {
             fieldsz += 2;
             if (fieldSzIncludeSign)
@@ -1157,7 +1361,7 @@ fioFormat(
         {
             fioBufPut(&sign, 1, outarg);
         }
-        else if (doHexPrefix)
+        if (doHexPrefix)
         {
             ox[0] = '0';
             ox[1] = (char)ch;
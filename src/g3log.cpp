@@ -22,10 +22,14 @@
 #include "g3log/logworker.hpp"
 #include "g3log/crashhandler.hpp"
 #include "g3log/logmessage.hpp"
+#include "g3log/logmessagepool.hpp"
 #include "g3log/loglevels.hpp"
+#include "g3log/logstaging.hpp"
+#include "g3log/logpreinit.hpp"
 
 
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
 #include <iostream>
 #include <thread>
@@ -40,12 +44,13 @@ namespace {
    // only one of the calls will actually run to completion.
    // std::once_flag is neither copyable nor movable.
    std::once_flag g_initialize_flag;
-   g3::LogWorker* g_logger_instance = nullptr; // instantiated and OWNED somewhere else (main)
-   std::mutex g_logging_init_mutex;
+   // instantiated and OWNED somewhere else (main). Atomic since it is read by any LOG call
+   // while it can be reset by the shutdown
+   std::atomic<g3::LogWorker*> g_logger_instance {nullptr};
+   // Exclusive for the initialization and the shutdown. Shared by the threads that hand
+   // messages to the logger, which must not be shut down meanwhile, so they do not wait for each other
+   std::shared_mutex g_logging_init_mutex;
 
-   std::unique_ptr<g3::LogMessage> g_first_uninitialized_msg = {nullptr};
-   std::once_flag g_set_first_uninitialized_flag;
-   std::once_flag g_save_first_uninitialized_flag;
    const std::function<void(void)> g_pre_fatal_hook_that_does_nothing = [] { /*does nothing */};
    std::function<void(void)> g_fatal_pre_logging_hook;
 
@@ -65,7 +70,7 @@ namespace g3 {
       std::call_once(g_initialize_flag, [] {
          installCrashHandler();
       });
-      std::lock_guard<std::mutex> lock(g_logging_init_mutex);
+      std::lock_guard<std::shared_mutex> lock(g_logging_init_mutex);
       if (internal::isLoggingInitialized() || nullptr == bgworker) {
          std::ostringstream exitMsg;
          exitMsg << __FILE__ "->" << __FUNCTION__ << ":" << __LINE__ << std::endl;
@@ -76,19 +81,14 @@ namespace g3 {
          std::exit(EXIT_FAILURE);
       }
 
-      // Save the first uninitialized message, if any
-      std::call_once(g_save_first_uninitialized_flag, [&bgworker] {
-         if (g_first_uninitialized_msg) {
-            // typedef MoveOnCopy<std::unique_ptr<g3::LogMessage>> LogMessagePtr;
-            // explicit MoveOnCopy(Moveable &&m) : _move_only(std::move(m)) {}
-            // Disambiguate with the universal initialisation syntax { ... } to 
-            // create a temporary MoveOnCopy<LogMessage> object, as long as 
-            // MoveOnCopy<LogMessage> class doesn't have a constructor that takes
-            // an initializer_list
-            bgworker->save(LogMessagePtr {std::move(g_first_uninitialized_msg)});
-         }
-      });
+      // The messages logged before the first initialization, if any, go first and as one batch.
+      // See g3log/logpreinit.hpp
+      LogMessageBatch kept = internal::replayPreInitMessages();
+      if (!kept.get().empty()) {
+         bgworker->saveBatch(kept);
+      }
 
+      bgworker->setStagingCollection(true);
       g_logger_instance = bgworker;
       // by default the pre fatal logging hook does nothing
       // if it WOULD do something it would happen in
@@ -145,8 +145,15 @@ namespace g3 {
        * Cannot invoke g3::internal::shutDownLogging() manually in your own project.
        */
       void shutDownLogging() {
-         std::lock_guard<std::mutex> lock(g_logging_init_mutex);
-         g_logger_instance = nullptr;
+#ifdef G3_LOG_STAGING
+         // the staged messages go to the LogWorker that is shut down
+         flushAllStagedMessages();
+#endif
+         std::lock_guard<std::shared_mutex> lock(g_logging_init_mutex);
+         auto logger = g_logger_instance.exchange(nullptr);
+         if (nullptr != logger) {
+            logger->setStagingCollection(false);
+         }
 
       }
 
@@ -175,16 +182,24 @@ namespace g3 {
       * i.e. (dlopen + dlsym)  */
       void saveMessage(const char* entry, const char* file, int line, const char* function, const LEVELS& level,
                        const char* boolean_expression, int fatal_signal, const char* stack_trace) {
-         LEVELS msgLevel {level};
          // explicit MoveOnCopy(Moveable &&m) : _move_only(std::move(m)) {}
          // std::move is implicitly applied to local objects being returned.
          // A local std::unique_ptr<LogMessage> object is returned by calling 
          // std::make_unique<LogMessage>( .. )
-         LogMessagePtr message {std::make_unique<LogMessage>(file, line, function, msgLevel)};
-         message.get()->write().append(entry);
-         message.get()->setExpression(boolean_expression);
+#ifdef G3_LOG_MESSAGE_POOL
+         // the LogWorker and the sinks give it back to the pool, as with the LOG calls
+         LogMessagePtr message {acquireLogMessage()};
+         message.get()->reuse(file, line, function, level, boolean_expression, entry, LogMessage::Details::Copy);
+#else
+         LogMessagePtr message {std::make_unique<LogMessage>(file, line, function, level, boolean_expression,
+                                                             entry, LogMessage::Details::Copy)};
+#endif
+         saveMessage(message, fatal_signal, stack_trace);
+      }
 
-         if (internal::wasFatal(level)) {
+
+      void saveMessage(LogMessagePtr message, int fatal_signal, const char* stack_trace) {
+         if (message.get()->wasFatal()) {
             // In case the fatal_pre logging actually will cause a crash in its turn
             // let's not do recursive crashing!
             auto fatalhook = setFatalPreLoggingHook(g_pre_fatal_hook_that_does_nothing);
@@ -229,30 +244,48 @@ namespace g3 {
       }
 
       /**
-       * save the message to the logger. In case of called before the logger is instantiated
-       * the first message will be saved. Any following subsequent uninitialized log calls
-       * will be ignored.
-       *
-       * The first initialized log entry will also save the first uninitialized log message, if any
+       * save the message to the logger. Messages logged before the logger is initialized
+       * the first time are kept and saved when it is, see g3log/logpreinit.hpp.
+       * Messages logged after the logging was shut down are ignored
        * @param log_entry to save to logger
        */
       void pushMessageToLogger(LogMessagePtr incoming) { // todo rename to Push SavedMessage To Worker
-         // Uninitialized messages are ignored but does not CHECK/crash the logger
+         // Uninitialized messages are kept or ignored but does not CHECK/crash the logger
          if (!internal::isLoggingInitialized()) {
-            std::call_once(g_set_first_uninitialized_flag, [&] {
-               g_first_uninitialized_msg = incoming.release();
-               std::string err = {"LOGGER NOT INITIALIZED:\n\t\t"};
-               err.append(g_first_uninitialized_msg->message());
-               std::string& str = g_first_uninitialized_msg->write();
-               str.clear();
-               str.append(err); // replace content
-               std::cerr << str << std::endl;
-            });
-            return;
+            std::unique_ptr<LogMessage> message = keepPreInitMessage(std::move(incoming.get()));
+            if (nullptr == message) {
+               return;
+            }
+            // The kept messages were replayed: the logging was initialized just now, the lock
+            // waits for initializeLogging to finish, or it was shut down
+            std::shared_lock<std::shared_mutex> lock(g_logging_init_mutex);
+            if (!internal::isLoggingInitialized()) {
+               return;
+            }
+            incoming.get() = std::move(message);
          }
 
          // logger is initialized
-         g_logger_instance->save(incoming);
+#ifdef G3_LOG_STAGING
+         stageMessage(std::move(incoming.get()));
+#else
+         auto logger = g_logger_instance.load();
+         if (nullptr != logger) {
+            logger->save(incoming);
+         }
+#endif
+      }
+
+
+      // The shared lock keeps the logger from being shut down, and destroyed, while the batch is
+      // handed to it. The threads that hand over their staging areas do not wait for each other
+      void pushBatchToLogger(LogMessageBatch batch) {
+         std::shared_lock<std::shared_mutex> lock(g_logging_init_mutex);
+         auto logger = g_logger_instance.load();
+         if (nullptr == logger) {
+            return;
+         }
+         logger->saveBatch(batch);
       }
 
       /** Fatal call saved to logger. This will trigger SIGABRT or other fatal signal
@@ -262,6 +295,7 @@ namespace g3 {
        */
       void pushFatalMessageToLogger(FatalMessagePtr message) {
          if (!isLoggingInitialized()) {
+            dumpPreInitMessages();
             std::ostringstream error;
             error << "FATAL CALL but logger is NOT initialized\n"
                   << "CAUSE: " << message.get()->reason()
@@ -269,7 +303,11 @@ namespace g3 {
             std::cerr << error.str() << std::flush;
             internal::exitWithDefaultSignalHandler(message.get()->_level, message.get()->_signal_id);
          }
-         g_logger_instance->fatal(message);
+#ifdef G3_LOG_STAGING
+         // the messages logged before the fatal event are written before it
+         flushAllStagedMessages(true);
+#endif
+         g_logger_instance.load()->fatal(message);
          while (shouldBlockForFatalHandling()) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
          }
@@ -20,20 +20,27 @@
 #pragma once
 
 #include <thread>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include "g3log/shared_queue.hpp"
 
 namespace kjellkod {
    typedef std::function< void() > Callback;
+   class Active;
+   typedef std::function< void(Active&) > PeriodicCallback;
 
    class Active {
    private:
-      Active() : done_(false) {} // Construction ONLY through factory createActive();
+      Active() : done_(false), period_(0) {} // Construction ONLY through factory createActive();
       Active(const Active &) = delete;
       Active &operator=(const Active &) = delete;
 
       void run() {
+         if (periodic_) {
+            runWithPeriodic();
+            return;
+         }
          while (!done_) {
             Callback func;
             mq_.wait_and_pop(func);
@@ -41,9 +48,27 @@ namespace kjellkod {
          }
       }
 
+      // as run(), but the thread also wakes up to call periodic_ every period_
+      void runWithPeriodic() {
+         auto next_periodic = std::chrono::steady_clock::now() + period_;
+         while (!done_) {
+            Callback func;
+            if (mq_.wait_and_pop_until(func, next_periodic)) {
+               func();
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (!done_ && now >= next_periodic) {
+               periodic_(*this);
+               next_periodic = now + period_;
+            }
+         }
+      }
+
       shared_queue<Callback> mq_;
       std::thread thd_;
       bool done_;
+      PeriodicCallback periodic_;
+      std::chrono::milliseconds period_;
 
    public:
       virtual ~Active() {
@@ -82,6 +107,17 @@ namespace kjellkod {
          // A value that is returned from a function is treated as an rvalue,
          // so the move constructor is called automatically.
       }
+
+      /// Factory: as above, and the thread calls 'periodic' every 'period', also when there
+      /// is nothing else to do. The calls are made between the queued messages and are given
+      /// the Active itself, e.g. to send more work to it
+      static std::unique_ptr<Active> createActive(PeriodicCallback periodic, std::chrono::milliseconds period) {
+         std::unique_ptr<Active> aPtr(new Active());
+         aPtr->periodic_ = periodic;
+         aPtr->period_ = period;
+         aPtr->thd_ = std::thread(&Active::run, aPtr.get());
+         return aPtr;
+      }
    };
 
 
@@ -0,0 +1,35 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+/** Branch prediction hints and function attributes for the LOG/CHECK macros
+ *
+ * G3_LIKELY(x)/G3_UNLIKELY(x): tells the compiler which way a condition usually goes, so
+ *    that the usual way is the straight line through the code
+ * G3_COLD: a function that is seldom called. It is never inlined, it is optimized for size
+ *    and the code leading to a call of it is moved away from the hot code, e.g. to
+ *    .text.unlikely with GCC. LogCapture is G3_COLD: of a LOG call only the level check
+ *    and the streaming of the arguments are left at the call site
+ * G3_NOINLINE: a function that is never inlined */
+#if defined(__GNUC__) || defined(__clang__)
+#define G3_LIKELY(x) __builtin_expect(!!(x), 1)
+#define G3_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define G3_COLD __attribute__((cold, noinline))
+#define G3_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define G3_LIKELY(x) (x)
+#define G3_UNLIKELY(x) (x)
+#define G3_COLD __declspec(noinline)
+#define G3_NOINLINE __declspec(noinline)
+#else
+#define G3_LIKELY(x) (x)
+#define G3_UNLIKELY(x) (x)
+#define G3_COLD
+#define G3_NOINLINE
+#endif
@@ -0,0 +1,207 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/generated_definitions.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace g3 {
+   namespace internal {
+      // The functions below read the characters through data() and search with their own loops.
+      // GCC cannot evaluate string_view's operator[] and find functions when it constant
+      // initializes a 'static const' CallSite, which would then get a thread safe
+      // initialization guard that each LOG call checks
+
+      /// @return true if 'word' is in 'text' at 'pos'
+      template <size_t N>
+      constexpr bool matchesAt(std::string_view text, size_t pos, const char (&word)[N]) {
+         if (pos + (N - 1) > text.size()) {
+            return false;
+         }
+         for (size_t i = 0; i + 1 < N; ++i) {
+            if (text.data()[pos + i] != word[i]) {
+               return false;
+            }
+         }
+         return true;
+      }
+
+      /// the file name that is shown in the log entries. Done at compile time for the call sites
+      constexpr std::string_view baseName(std::string_view file_path) {
+#if defined(G3_LOG_FULL_FILENAME)
+         return file_path;
+#else
+         for (size_t end = file_path.size(); end > 0; --end) {
+            const char c = file_path.data()[end - 1];
+            if (c == '(' || c == '/' || c == '\\') {
+               return file_path.substr(end);
+            }
+         }
+         return file_path;
+#endif
+      }
+
+      constexpr bool isIdentifierChar(char c) {
+         return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+      }
+
+      /** Shortens a __PRETTY_FUNCTION__ to "Class::method" at compile time
+       * "int ns::Class<int, char>::method(const std::string&) const" -> "Class<int, char>::method"
+       * "T ns::f(T) [with T = int]" -> "ns::f"
+       * Anything that does not look like a function signature (a GCC lambda "main()::<lambda()>"
+       * or MSVC's __FUNCTION__) is returned as it is, apart from a " [with ...]" suffix */
+      constexpr std::string_view shortFunctionName(std::string_view pretty) {
+         size_t suffix = 0;
+         while (suffix < pretty.size() && !matchesAt(pretty, suffix, " [")) {
+            ++suffix;
+         }
+         const std::string_view name = pretty.substr(0, suffix);
+         const char* text = name.data();
+
+         // skip the qualifiers after the parameter list: const, volatile, &, &&, noexcept
+         size_t close = name.size();
+         while (close > 0 && text[close - 1] != ')') {
+            const char c = text[close - 1];
+            if (!(isIdentifierChar(c) || c == ' ' || c == '&')) {
+               return name;
+            }
+            --close;
+         }
+         if (0 == close) {
+            return name;
+         }
+
+         // back to the start of the parameter list
+         size_t open = close;
+         int depth = 0;
+         while (open > 0) {
+            --open;
+            if (text[open] == ')') {
+               ++depth;
+            } else if (text[open] == '(' && 0 == --depth) {
+               break;
+            }
+         }
+         if (0 != depth || 0 == open) {
+            return name;
+         }
+
+         // operators contain characters that would otherwise end the name, e.g. "operator>"
+         size_t begin = open;
+         for (size_t op = open; op-- > 0;) {
+            if (matchesAt(name, op, "operator")) {
+               if ((0 == op || !isIdentifierChar(text[op - 1])) && !isIdentifierChar(text[op + 8])) {
+                  begin = op;
+               }
+               break;
+            }
+         }
+
+         // back to the space in front of the name, template arguments might contain spaces.
+         // At most two name components are kept
+         int angles = 0;
+         int parens = 0;
+         int components = 0;
+         while (begin > 0) {
+            const char c = text[begin - 1];
+            if (c == '>') {
+               ++angles;
+            } else if (c == '<') {
+               angles -= (angles > 0) ? 1 : 0;
+            } else if (c == ')') {
+               ++parens;
+            } else if (c == '(') {
+               parens -= (parens > 0) ? 1 : 0;
+            } else if (0 == angles && 0 == parens) {
+               if (c == ' ' || c == '*' || c == '&') {
+                  break;
+               }
+               if (c == ':' && begin >= 2 && text[begin - 2] == ':') {
+                  if (2 == ++components) {
+                     break;
+                  }
+                  --begin;
+               }
+            }
+            --begin;
+         }
+         return name.substr(begin, open - begin);
+      }
+
+      /// @return true if the address belongs to the executable itself, which is never unloaded.
+      /// Addresses in shared libraries return false since they might be unloaded with dlclose
+      bool isInExecutable(const void* address);
+
+#if defined(G3_LOG_VMODULE)
+      /// CallSite::module_rule of a call site whose file matches no module rule
+      const int32_t kNoModuleRule = std::numeric_limits<int32_t>::min();
+#endif
+   } // internal
+
+
+   /** Static description of one LOG/CHECK call site. The macros in g3log.hpp declare one
+    * per call site, constant initialized, so it costs nothing at runtime.
+    *
+    * A LogMessage from a call site refers to the strings here instead of copying them, but
+    * only if the call site is in the executable. A call site in a shared library is copied
+    * into each message, since the library might be unloaded (dlclose) while its messages
+    * are still in the queue to the background worker. With G3_LOG_INPLACE_CAPTURE the
+    * strings are always referred to.
+    *
+    * With G3_LOG_VMODULE the call site also caches the module rule of its file, see
+    * g3log/vmodule.hpp */
+   struct CallSite {
+      constexpr CallSite(std::string_view path, std::string_view function_name, int line_number)
+         : file_path(path), file(internal::baseName(path))
+         , function(function_name), short_function(internal::shortFunctionName(function_name))
+         , line(line_number)
+#if defined(G3_LOG_VMODULE)
+         , module_rule(static_cast<uint32_t>(internal::kNoModuleRule))
+#endif
+         , _policy(kUnknown) {}
+      CallSite(const CallSite&) = delete;
+      CallSite& operator=(const CallSite&) = delete;
+
+      /// @return true if a LogMessage can refer to the strings of this call site
+      bool referable() const {
+#if defined(G3_LOG_INPLACE_CAPTURE)
+         return true;
+#else
+         int policy = _policy.load(std::memory_order_relaxed);
+         if (kUnknown == policy) {
+            // benign race: all threads come to the same conclusion
+            policy = internal::isInExecutable(this) ? kReference : kCopy;
+            _policy.store(policy, std::memory_order_relaxed);
+         }
+         return kReference == policy;
+#endif
+      }
+
+      const std::string_view file_path;
+      const std::string_view file;
+      const std::string_view function;
+      const std::string_view short_function; // "Class::method", part of 'function'
+      const int line;
+
+#if defined(G3_LOG_VMODULE)
+      /// The rules' generation in the upper 32 bits, the minimum level value of the rule that
+      /// matches the file in the lower 32 bits, kNoModuleRule if none does. Starts out as
+      /// generation 0, when there are no rules
+      mutable std::atomic<uint64_t> module_rule;
+#endif
+
+    private:
+      enum { kUnknown, kReference, kCopy };
+      mutable std::atomic<int> _policy;
+   };
+} // g3
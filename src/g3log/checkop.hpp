@@ -0,0 +1,155 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/attributes.hpp"
+
+#include <cctype>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/** The comparisons of CHECK_EQ, CHECK_NE, CHECK_LT, CHECK_LE, CHECK_GT and CHECK_GE in g3log.hpp
+ *
+ * Each operand is evaluated once, by the call of the check function. The check function is
+ * inline and does the comparison and nothing else. Only if the comparison fails are the
+ * operands written to a text, "(3 vs 7) ", by the G3_COLD checkFailed, which is where the
+ * text is allocated. The failed contract's message starts with that text */
+namespace g3 {
+   namespace internal {
+      /// The result of a comparison. Converts to true if the comparison held
+      struct CheckResult {
+         std::unique_ptr<std::string> failure; // the operands' values, only set if it failed
+
+         explicit operator bool() const {
+            return nullptr == failure;
+         }
+
+         const std::string& values() const {
+            return *failure;
+         }
+      };
+
+
+      template <typename T, typename = void>
+      struct IsStreamable : std::false_type {};
+
+      template <typename T>
+      struct IsStreamable<T, std::void_t<decltype(std::declval<std::ostream&>() << std::declval<const T&>())>>
+         : std::true_type {};
+
+      /// Pointers to characters, which operator<< writes as C strings
+      template <typename T>
+      struct IsCharPointer : std::false_type {};
+
+      template <typename T>
+      struct IsCharPointer<T*> : std::bool_constant<std::is_same<std::remove_cv_t<T>, char>::value
+                                                    || std::is_same<std::remove_cv_t<T>, signed char>::value
+                                                    || std::is_same<std::remove_cv_t<T>, unsigned char>::value> {};
+
+      /// Writes an operand of a failed comparison. Characters are written with their code, since
+      /// an unprintable one would otherwise be invisible. A null C string is written as "nullptr",
+      /// streaming it would fail the stream. A type without operator<< is written as
+      /// its underlying value if it is an enum, else as "<not printable>"
+      template <typename T>
+      void writeCheckOperand(std::ostream& out, const T& value) {
+         if constexpr (std::is_same<T, char>::value || std::is_same<T, signed char>::value
+                       || std::is_same<T, unsigned char>::value) {
+            if (std::isprint(static_cast<unsigned char>(value))) {
+               out << '\'' << static_cast<char>(value) << "' ";
+            }
+            out << "(" << static_cast<int>(value) << ")";
+         } else if constexpr (std::is_same<T, std::nullptr_t>::value) {
+            out << "nullptr";
+         } else if constexpr (IsCharPointer<T>::value) {
+            if (nullptr == value) {
+               out << "nullptr";
+            } else {
+               out << value;
+            }
+         } else if constexpr (IsStreamable<T>::value) {
+            out << value;
+         } else if constexpr (std::is_enum<T>::value) {
+            out << static_cast<typename std::underlying_type<T>::type>(value);
+         } else {
+            out << "<not printable>";
+         }
+      }
+
+      /// Numbers, pointers and enums are given to checkFailed by value. By reference they would
+      /// be stored to memory before the comparison, on the success path
+      template <typename T>
+      using CheckOperand = typename std::conditional<std::is_scalar<T>::value, T, const T&>::type;
+
+      template <typename A, typename B>
+      G3_COLD CheckResult checkFailed(CheckOperand<A> a, CheckOperand<B> b) {
+         std::ostringstream values;
+         values << "(";
+         writeCheckOperand(values, a);
+         values << " vs ";
+         writeCheckOperand(values, b);
+         values << ") ";
+         return CheckResult{std::make_unique<std::string>(values.str())};
+      }
+
+      /// A signed and an unsigned integer. 'a op b' would convert the signed one to unsigned, -1 would
+      /// be more than 0u, and warn with -Wsign-compare where the written out CHECK(a op b) does not
+      template <typename A, typename B>
+      struct IsMixedSignIntegers
+         : std::bool_constant<std::is_integral<A>::value && std::is_integral<B>::value
+                              && !std::is_same<A, bool>::value && !std::is_same<B, bool>::value
+                              && (std::is_signed<A>::value != std::is_signed<B>::value)> {};
+
+      /// As C++20's std::cmp_equal and std::cmp_less: a negative number is less than any unsigned one
+      template <typename A, typename B>
+      constexpr bool cmpEqual(A a, B b) noexcept {
+         if constexpr (std::is_signed<A>::value) {
+            return a >= 0 && static_cast<std::make_unsigned_t<A>>(a) == b;
+         } else {
+            return b >= 0 && a == static_cast<std::make_unsigned_t<B>>(b);
+         }
+      }
+
+      template <typename A, typename B>
+      constexpr bool cmpLess(A a, B b) noexcept {
+         if constexpr (std::is_signed<A>::value) {
+            return a < 0 || static_cast<std::make_unsigned_t<A>>(a) < b;
+         } else {
+            return b >= 0 && a < static_cast<std::make_unsigned_t<B>>(b);
+         }
+      }
+
+#define G3_INTERNAL_DEFINE_CHECK_OP(name, op, mixed_sign) \
+      template <typename A, typename B> \
+      inline CheckResult check##name(const A& a, const B& b) { \
+         bool held; \
+         if constexpr (IsMixedSignIntegers<A, B>::value) { \
+            held = (mixed_sign); \
+         } else { \
+            held = (a op b); \
+         } \
+         if (G3_LIKELY(held)) { \
+            return CheckResult{}; \
+         } \
+         return checkFailed<A, B>(a, b); \
+      }
+
+      G3_INTERNAL_DEFINE_CHECK_OP(EQ, ==, cmpEqual(a, b))
+      G3_INTERNAL_DEFINE_CHECK_OP(NE, !=, !cmpEqual(a, b))
+      G3_INTERNAL_DEFINE_CHECK_OP(LT, <, cmpLess(a, b))
+      G3_INTERNAL_DEFINE_CHECK_OP(LE, <=, !cmpLess(b, a))
+      G3_INTERNAL_DEFINE_CHECK_OP(GT, >, cmpLess(b, a))
+      G3_INTERNAL_DEFINE_CHECK_OP(GE, >=, !cmpLess(a, b))
+#undef G3_INTERNAL_DEFINE_CHECK_OP
+   } // internal
+} // g3
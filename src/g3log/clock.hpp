@@ -0,0 +1,83 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/generated_definitions.hpp"
+#include "g3log/time.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(G3_LOG_CLOCK_COARSE) && defined(__linux__)
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** The clock that time stamps the log entries, chosen with G3_LOG_CLOCK in Options.cmake
+ *
+ *  HIGH_RESOLUTION (default): std::chrono::high_resolution_clock
+ *  COARSE: the kernel's coarse clock (CLOCK_REALTIME_COARSE or CLOCK_MONOTONIC_COARSE),
+ *          read from the vDSO without a system call. Resolution is the scheduler tick,
+ *          1-4 ms. Only on Linux, other platforms use the default clock
+ *  TSC:    the raw CPU counter (rdtsc on x86, cntvct_el0 on ARM64). The LogWorker converts
+ *          it to time, with a mapping it recalibrates every second. Needs an invariant
+ *          TSC, which all x86 CPUs of the last decade have */
+namespace g3 {
+   namespace internal {
+      /// how often the LogWorker recalibrates the clock mappings, see refreshClockCalibration
+      const std::chrono::seconds kClockCalibrationInterval {1};
+
+      /// the raw CPU counter, or the nanoseconds of the high_resolution_clock on a CPU without one
+      inline uint64_t cpuTicks() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+         return __rdtsc();
+#elif defined(__aarch64__)
+         uint64_t ticks;
+         asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+         return ticks;
+#else
+         using namespace std::chrono;
+         return static_cast<uint64_t>(duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count());
+#endif
+      }
+
+      /// 'now' with the G3_LOG_CLOCK_COARSE clock, or the default clock
+      inline high_resolution_time_point timestampNow() {
+         using namespace std::chrono;
+#if defined(G3_LOG_CLOCK_COARSE) && defined(__linux__)
+         // the coarse version of the clock behind the high_resolution_clock, so no conversion is needed
+         const clockid_t coarse = std::is_same<high_resolution_clock, system_clock>::value ? CLOCK_REALTIME_COARSE
+                                  : std::is_same<high_resolution_clock, steady_clock>::value ? CLOCK_MONOTONIC_COARSE
+                                  : -1;
+         timespec now;
+         if (coarse != -1 && 0 == clock_gettime(coarse, &now)) {
+            const auto since_epoch = seconds(now.tv_sec) + nanoseconds(now.tv_nsec);
+            return high_resolution_time_point(duration_cast<high_resolution_clock::duration>(since_epoch));
+         }
+#endif
+         return high_resolution_clock::now();
+      }
+
+      /// converts a cpuTicks() reading to the high_resolution_clock, with the current calibration
+      high_resolution_time_point ticksToTimePoint(uint64_t ticks);
+
+      /// system_clock minus high_resolution_clock. Always zero if they are the same clock
+      std::chrono::nanoseconds systemClockOffset();
+
+      /// measures the mappings of the TSC and the high_resolution_clock anew, if the last
+      /// time was more than kClockCalibrationInterval ago. Called by the LogWorker
+      void refreshClockCalibration();
+   } // internal
+} // g3
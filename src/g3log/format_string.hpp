@@ -3,6 +3,10 @@
 #include <string.h>
 #include <stdarg.h> // va_list and its operations
 
+// tz_vsnprintf/tz_snprintf format like the C99 vsnprintf/snprintf: same conversions, same
+// output as glibc and the same return value. The LOGF engine with G3_LOGF_BACKEND=TZ,
+// see Options.cmake
+
 int
 tz_vsnprintf(
     char* buffer,         // buffer to write to
@@ -24,10 +24,14 @@
 #include "g3log/loglevels.hpp"
 #include "g3log/logcapture.hpp"
 #include "g3log/logmessage.hpp"
+#include "g3log/ratelimit.hpp"
+#include "g3log/checkop.hpp"
+#include "g3log/vmodule.hpp"
 #include "g3log/generated_definitions.hpp"
 
 #include <string>
 #include <functional>
+#include <type_traits>
 
 
 #if !(defined(__PRETTY_FUNCTION__))
@@ -93,9 +97,9 @@ namespace g3 {
   // only_change_at_initialization namespace is for changes to be done only during initialization. More specifically
   // items here would be called prior to calling other parts of g3log
   namespace only_change_at_initialization {
-    // Sets the MaxMessageSize to be used when capturing log messages. Currently this value is set to 2KB. Messages
-    // Longer than this are bound to 2KB with the string "[...truncated...]" at the end. This function allows
-    // this limit to be changed.
+    // Sets the MaxMessageSize to be used when capturing printf-like log messages. Currently this value is set to 2KB.
+    // Messages longer than this are bound to 2KB with the string "[...truncated...]" at the end. This function allows
+    // this limit to be changed. Without G3_DYNAMIC_MAX_MESSAGE_SIZE there is no limit at all.
     void setMaxMessageSize(size_t max_size);
   }
 #endif /* G3_DYNAMIC_MAX_MESSAGE_SIZE */
@@ -110,9 +114,17 @@ namespace g3 {
       void saveMessage(const char* message, const char* file, int line, const char* function, const LEVELS& level,
                        const char* boolean_expression, int fatal_signal, const char* stack_trace);
 
+      // Save an already created LogMessage. Used by LogCapture which builds the message
+      // directly instead of having it copied once more by the function above
+      void saveMessage(LogMessagePtr message, int fatal_signal, const char* stack_trace);
+
       // forwards the message to all sinks
       void pushMessageToLogger(LogMessagePtr log_entry);
 
+      // forwards the messages, in order, to all sinks. Used for the staged messages of a
+      // thread, see g3log/logstaging.hpp. Ignored if the logger is not initialized
+      void pushBatchToLogger(LogMessageBatch batch);
+
 
       // forwards a FATAL message to all sinks,. after which the g3logworker
       // will trigger crashhandler / g3::internal::exitWithDefaultSignalHandler
@@ -154,18 +166,131 @@ namespace g3 {
    LogCapture(__FILE__, __LINE__, static_cast<const char*>(__PRETTY_FUNCTION__), g3::internal::CONTRACT, boolean_expression)
 
 
+// Each LOG/CHECK call declares a static g3::CallSite in the init-statement of its 'if'.
+// It is constant initialized, i.e. no runtime cost, and it is only visible to that statement.
+// The log message refers to it instead of copying the file and function names, see g3::CallSite.
+// The names are given with their length: a string_view that counts the length of a
+// 'const char*' stops GCC from constant initializing the CallSite
+#define INTERNAL_CALL_SITE g3_log_call_site
+#define INTERNAL_LITERAL_VIEW(literal) std::string_view(literal, sizeof(literal) - 1)
+#define INTERNAL_CALL_SITE_DECLARATION \
+   static const g3::CallSite INTERNAL_CALL_SITE{INTERNAL_LITERAL_VIEW(__FILE__), INTERNAL_LITERAL_VIEW(__PRETTY_FUNCTION__), __LINE__}
+
+#define INTERNAL_SITE_LOG_MESSAGE(level) \
+   LogCapture(INTERNAL_CALL_SITE, level)
+
+#define INTERNAL_SITE_CONTRACT_MESSAGE(boolean_expression) \
+   LogCapture(INTERNAL_CALL_SITE, g3::internal::CONTRACT, boolean_expression)
+
+// A LOG call at a built-in level below G3_LOG_MIN_LEVEL is discarded at compile time: it is
+// still compiled, so the streamed arguments are type checked, but no code is generated and the
+// arguments are not evaluated. See G3_MIN_LOG_LEVEL in Options.cmake. The lambda only names
+// g3::internal::level_tags in place of the levels for the decltype, it is never called at runtime
+#define INTERNAL_COMPILED_IN(level) \
+   if constexpr (![&] { \
+         using g3::internal::level_tags::G3LOG_DEBUG; using g3::internal::level_tags::INFO; \
+         using g3::internal::level_tags::WARNING; using g3::internal::level_tags::FATAL; \
+         return g3::internal::CompiledIn<std::remove_cv_t<std::remove_reference_t<decltype(level)>>>::value; }()) {} else
+
+// Is the level enabled for this call site: g3::logLevel(level), unless a module rule for the
+// call site's file decides. See g3log/vmodule.hpp
+#define INTERNAL_LOG_ENABLED(level) \
+   g3::internal::logEnabled(INTERNAL_CALL_SITE, level)
+
+// The 'if' of each LOG/CHECK call is G3_LIKELY to skip the message: the skipping is the straight
+// line through the caller's code. What is left inline at the call site is the level check and
+// the streaming of the arguments, the LogCapture it streams to is G3_COLD, see g3log/attributes.hpp
+
+
 // LOG(level) is the API for the stream log
 #define LOG(level) \
-   if (!g3::logLevel(level)) {} else INTERNAL_LOG_MESSAGE(level).stream()
+   INTERNAL_COMPILED_IN(level) if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(!INTERNAL_LOG_ENABLED(level))) {} else INTERNAL_SITE_LOG_MESSAGE(level).stream()
 
 // 'Conditional' stream log
 #define LOG_IF(level, boolean_expression) \
-   if (!g3::logLevel(level) || false == (boolean_expression)) {} else INTERNAL_LOG_MESSAGE(level).stream()
+   INTERNAL_COMPILED_IN(level) if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(!INTERNAL_LOG_ENABLED(level) || false == (boolean_expression))) {} else INTERNAL_SITE_LOG_MESSAGE(level).stream()
+
+// Hex dump of 'size' bytes at 'data', at most g3::kHexDumpMaxBytes of them. See g3log/hexdump.hpp
+// The bytes are not read at all when the level is disabled
+#define LOG_HEX(level, data, size) \
+   LOG(level) << g3::hexdump(data, size)
+
+// Lazy stream log: the text of the callable, e.g. [snapshot = ...]{ return render(snapshot); },
+// is made by the background worker and appended to the message. The callable must own what it
+// uses, it is called after the LOG_LAZY call has returned. See g3log/loglazy.hpp
+#define LOG_LAZY(level, ...) \
+   INTERNAL_COMPILED_IN(level) if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(!INTERNAL_LOG_ENABLED(level))) {} else INTERNAL_SITE_LOG_MESSAGE(level).lazy(__VA_ARGS__).stream()
+
+/** Rate limited stream logs, for a call site that could flood the log. The counters are per
+ * call site, shared by all threads, see g3log/ratelimit.hpp. A message that is logged after
+ * some were suppressed ends with "(suppressed N since last)". Only messages at an enabled
+ * level are counted
+ *  LOG_EVERY_N(level, n): the 1st, n+1th, 2n+1th ... message
+ *  LOG_FIRST_N(level, n): the first n messages
+ *  LOG_EVERY_T(level, seconds): at most one message per 'seconds', a double
+ *  LOG_EVERY_N_IF(level, n, boolean_expression): LOG_EVERY_N of the messages where the
+ *                                                expression is true */
+#define INTERNAL_LIMITED_CALL_SITE_DECLARATION(limit) \
+   static const g3::internal::LimitedCallSite<g3::internal::limit> INTERNAL_CALL_SITE{INTERNAL_LITERAL_VIEW(__FILE__), INTERNAL_LITERAL_VIEW(__PRETTY_FUNCTION__), __LINE__}
+
+#define INTERNAL_LIMITED_LOG(limit, level, skip, ...) \
+   if (INTERNAL_LIMITED_CALL_SITE_DECLARATION(limit); \
+       const g3::internal::Sample g3_log_sample = G3_LIKELY(skip) ? g3::internal::Sample{} : INTERNAL_CALL_SITE.sample(__VA_ARGS__)) {} \
+   else INTERNAL_SITE_LOG_MESSAGE(level).suppressed(g3_log_sample.suppressed).stream()
+
+#define LOG_EVERY_N(level, n) \
+   INTERNAL_COMPILED_IN(level) INTERNAL_LIMITED_LOG(EveryN, level, !INTERNAL_LOG_ENABLED(level), n)
+
+#define LOG_FIRST_N(level, n) \
+   INTERNAL_COMPILED_IN(level) INTERNAL_LIMITED_LOG(FirstN, level, !INTERNAL_LOG_ENABLED(level), n)
+
+#define LOG_EVERY_T(level, seconds) \
+   INTERNAL_COMPILED_IN(level) INTERNAL_LIMITED_LOG(EveryT, level, !INTERNAL_LOG_ENABLED(level), seconds)
+
+#define LOG_EVERY_N_IF(level, n, boolean_expression) \
+   INTERNAL_COMPILED_IN(level) INTERNAL_LIMITED_LOG(EveryN, level, !INTERNAL_LOG_ENABLED(level) || false == (boolean_expression), n)
 
 // 'Design By Contract' stream API. Broken Contracts will exit the application by using fatal signal SIGABRT
 //  For unit testing, you can override the fatal handling using setFatalExitHandler(...). See tes_io.cpp for examples
 #define CHECK(boolean_expression) \
-   if (true == (boolean_expression)) {} else INTERNAL_CONTRACT_MESSAGE(#boolean_expression).stream()
+   if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(true == (boolean_expression))) {} else INTERNAL_SITE_CONTRACT_MESSAGE(#boolean_expression).stream()
+
+/** 'Design By Contract' comparisons: CHECK_EQ(a, b) << ... is CHECK(a == b) << ..., where a and
+ * b are evaluated once and the message of a broken contract starts with their values:
+ * "(3 vs 7) ...". The values are only formatted if the comparison fails, see g3log/checkop.hpp.
+ * A signed and an unsigned integer are compared by their values, as std::cmp_less: -1 < 0u.
+ * The operands need an operator<< to be shown */
+#define INTERNAL_CHECK_OP(name, op, a, b) \
+   if (INTERNAL_CALL_SITE_DECLARATION; const g3::internal::CheckResult g3_check_result = g3::internal::check##name((a), (b))) {} \
+   else INTERNAL_SITE_CONTRACT_MESSAGE(#a " " #op " " #b).stream() << g3_check_result.values()
+
+#define CHECK_EQ(a, b) INTERNAL_CHECK_OP(EQ, ==, a, b)
+#define CHECK_NE(a, b) INTERNAL_CHECK_OP(NE, !=, a, b)
+#define CHECK_LT(a, b) INTERNAL_CHECK_OP(LT, <, a, b)
+#define CHECK_LE(a, b) INTERNAL_CHECK_OP(LE, <=, a, b)
+#define CHECK_GT(a, b) INTERNAL_CHECK_OP(GT, >, a, b)
+#define CHECK_GE(a, b) INTERNAL_CHECK_OP(GE, >=, a, b)
+
+
+/** Debug only logs and contracts. Without NDEBUG they are the same as LOG, CHECK etc. With
+ * NDEBUG, as in a release build, they are discarded at compile time like the LOG calls below
+ * G3_LOG_MIN_LEVEL: type checked, but neither the expressions nor the streamed arguments are
+ * evaluated */
+#if defined(NDEBUG)
+#define INTERNAL_DEBUG_ONLY if constexpr (true) {} else
+#else
+#define INTERNAL_DEBUG_ONLY
+#endif
+
+#define DLOG(level) INTERNAL_DEBUG_ONLY LOG(level)
+#define DLOG_IF(level, boolean_expression) INTERNAL_DEBUG_ONLY LOG_IF(level, boolean_expression)
+#define DCHECK(boolean_expression) INTERNAL_DEBUG_ONLY CHECK(boolean_expression)
+#define DCHECK_EQ(a, b) INTERNAL_DEBUG_ONLY CHECK_EQ(a, b)
+#define DCHECK_NE(a, b) INTERNAL_DEBUG_ONLY CHECK_NE(a, b)
+#define DCHECK_LT(a, b) INTERNAL_DEBUG_ONLY CHECK_LT(a, b)
+#define DCHECK_LE(a, b) INTERNAL_DEBUG_ONLY CHECK_LE(a, b)
+#define DCHECK_GT(a, b) INTERNAL_DEBUG_ONLY CHECK_GT(a, b)
+#define DCHECK_GE(a, b) INTERNAL_DEBUG_ONLY CHECK_GE(a, b)
 
 
 /** For details please see this
@@ -217,21 +342,53 @@ And here is possible output
 :      Width trick:    10
 :      A string  \endverbatim */
 #define LOGF(level, printf_like_message, ...) \
-   if (!g3::logLevel(level)) {} else INTERNAL_LOG_MESSAGE(level).capturef(printf_like_message, ##__VA_ARGS__)
+   INTERNAL_COMPILED_IN(level) if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(!INTERNAL_LOG_ENABLED(level))) {} else INTERNAL_SITE_LOG_MESSAGE(level).capturef(printf_like_message, ##__VA_ARGS__)
 
 // Conditional log printf syntax
 #define LOGF_IF(level, boolean_expression, printf_like_message, ...) \
-   if (!g3::logLevel(level) || false == (boolean_expression)) {} else INTERNAL_LOG_MESSAGE(level).capturef(printf_like_message, ##__VA_ARGS__)
+   INTERNAL_COMPILED_IN(level) if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(!INTERNAL_LOG_ENABLED(level) || false == (boolean_expression))) {} else INTERNAL_SITE_LOG_MESSAGE(level).capturef(printf_like_message, ##__VA_ARGS__)
 
 // Design By Contract, printf-like API syntax with variadic input parameters.
 // Calls the signal handler if the contract failed with the default exit for a failed contract. This is typically SIGABRT
 // See g3log, setFatalExitHandler(...) which can be overriden for unit tests (ref test_io.cpp)
 #define CHECKF(boolean_expression, printf_like_message, ...) \
-   if (true == (boolean_expression)) {} else INTERNAL_CONTRACT_MESSAGE(#boolean_expression).capturef(printf_like_message, ##__VA_ARGS__)
+   if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(true == (boolean_expression))) {} else INTERNAL_SITE_CONTRACT_MESSAGE(#boolean_expression).capturef(printf_like_message, ##__VA_ARGS__)
 
 // Backwards compatible. The same as CHECKF.
 // Design By Contract, printf-like API syntax with variadic input parameters.
 // Calls the signal handler if the contract failed. See g3log, setFatalExitHandler(...) which can be overriden for unit tests
 // (ref test_io.cpp)
 #define CHECK_F(boolean_expression, printf_like_message, ...) \
-   if (true == (boolean_expression)) {} else INTERNAL_CONTRACT_MESSAGE(#boolean_expression).capturef(printf_like_message, ##__VA_ARGS__)
+   if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(true == (boolean_expression))) {} else INTERNAL_SITE_CONTRACT_MESSAGE(#boolean_expression).capturef(printf_like_message, ##__VA_ARGS__)
+
+// Debug only printf-like log and contract, see DLOG
+#define DLOGF(level, printf_like_message, ...) INTERNAL_DEBUG_ONLY LOGF(level, printf_like_message, ##__VA_ARGS__)
+#define DCHECKF(boolean_expression, printf_like_message, ...) INTERNAL_DEBUG_ONLY CHECKF(boolean_expression, printf_like_message, ##__VA_ARGS__)
+
+
+/** "{}" formatting API, a type safe alternative to the printf-like API above.
+ * The format string must be a string literal. It is parsed and checked against the
+ * arguments at compile time: a wrong number of arguments, an unknown format
+ * specification or a specification that does not fit the argument type will not compile.
+ * The text is written directly to the message, without any size limit.
+ * For the supported syntax see g3log/logformat.hpp
+ * \verbatim
+ EXAMPLES:
+   LOGFMT(INFO, "Decimals: {} {}", 1977, 650000L);
+   LOGFMT(INFO, "Preceding with blanks: {:10}", 1977);
+   LOGFMT(INFO, "Preceding with zeros: {:010}", 1977);
+   LOGFMT(INFO, "Some different radixes: {} {:x} {:o} {:#x} {:#o}", 100, 100, 100, 100, 100);
+   LOGFMT(INFO, "floats: {:4.2f} {:+.0e} {:E}", 3.1416, 3.1416, 3.1416);
+   LOGFMT(INFO, "{:>8} | {:<8} | {:^8} | {{literal braces}}", "right", "left", "center");
+ \endverbatim */
+#define LOGFMT(level, format, ...) \
+   INTERNAL_COMPILED_IN(level) if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(!INTERNAL_LOG_ENABLED(level))) {} else INTERNAL_SITE_LOG_MESSAGE(level).capturefmt(G3_FORMAT_STRING(format), ##__VA_ARGS__)
+
+// Conditional log with "{}" formatting
+#define LOGFMT_IF(level, boolean_expression, format, ...) \
+   INTERNAL_COMPILED_IN(level) if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(!INTERNAL_LOG_ENABLED(level) || false == (boolean_expression))) {} else INTERNAL_SITE_LOG_MESSAGE(level).capturefmt(G3_FORMAT_STRING(format), ##__VA_ARGS__)
+
+// Design By Contract with "{}" formatting. Calls the signal handler if the contract failed,
+// just like CHECK and CHECKF. See g3log, setFatalExitHandler(...) for unit tests (ref test_io.cpp)
+#define CHECKFMT(boolean_expression, format, ...) \
+   if (INTERNAL_CALL_SITE_DECLARATION; G3_LIKELY(true == (boolean_expression))) {} else INTERNAL_SITE_CONTRACT_MESSAGE(#boolean_expression).capturefmt(G3_FORMAT_STRING(format), ##__VA_ARGS__)
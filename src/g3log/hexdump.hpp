@@ -0,0 +1,71 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/** Hex dumps of binary data, such as packets or file headers
+ *
+ *    LOG_HEX(DEBUG, packet.data(), packet.size());
+ *    LOG(DEBUG) << "received " << g3::hexdump(packet.data(), packet.size());
+ *
+ * The dump is written as "[20 bytes]" followed by one line per 16 bytes, as 'hexdump -C' does:
+ *
+ *    00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 0a 00 01 02  |Hello, world....|
+ *    00000010  03 04 05 06                                       |....|
+ *
+ * At most 'max_bytes' bytes are dumped, "[4096 of 100000 bytes]", so that a wrong size can not
+ * make a huge message. The bytes are read when the g3::hexdump is streamed, at the LOG call.
+ * With deferred formatting (see Options.cmake: USE_G3_DEFERRED_FORMATTING) they are only copied
+ * into the message, the dump is written by the background worker. */
+namespace g3 {
+   /// the default limit of the bytes in one dump
+   const size_t kHexDumpMaxBytes = 4096;
+
+   struct HexDump {
+      const unsigned char* data;
+      size_t size;  // the bytes that are dumped
+      size_t total; // the size that was asked for, larger than 'size' if it was cut at max_bytes
+   };
+
+   inline HexDump hexdump(const void* data, size_t size, size_t max_bytes = kHexDumpMaxBytes) {
+      // nothing can be read from a nullptr, it is dumped as "[0 of 'size' bytes]"
+      const size_t shown = (nullptr == data) ? 0 : ((size < max_bytes) ? size : max_bytes);
+      return HexDump{static_cast<const unsigned char*>(data), shown, size};
+   }
+
+   /// for other streams than the LOG stream
+   std::ostream& operator<<(std::ostream& out, const HexDump& dump);
+
+
+   namespace internal {
+      const size_t kHexDumpBytesPerLine = 16;
+      // "[" size " of " total " bytes]"
+      const size_t kHexDumpMaxHeaderLength = 1 + 20 + 4 + 20 + 7;
+      // "\n" offset "  " hex columns " |" characters "|". The offset has 8 digits, up to 16 for a
+      // dump above 4GB. The hex columns are "xx " per byte with one more space in the middle
+      const size_t kHexDumpMaxLineLength = 1 + 16 + 2 + (kHexDumpBytesPerLine * 3 + 1) + 2 + kHexDumpBytesPerLine + 1;
+
+      /// the most characters that the dump of 'size' bytes can need, the header included
+      constexpr size_t hexDumpLength(size_t size) {
+         return kHexDumpMaxHeaderLength + ((size + kHexDumpBytesPerLine - 1) / kHexDumpBytesPerLine) * kHexDumpMaxLineLength;
+      }
+
+      /// writes the header "[20 bytes]" or "[4096 of 100000 bytes]". 'out' must have room for
+      /// hexDumpLength(0) characters. @return the end of what was written
+      char* writeHexDumpHeader(char* out, size_t size, size_t total);
+
+      /// writes the lines of 'size' bytes, each one starting with a '\n'. The first line is at
+      /// 'offset' into the dump. 'out' must have room for hexDumpLength(size) characters.
+      /// @return the end of what was written
+      char* writeHexDumpLines(char* out, const unsigned char* data, size_t size, size_t offset);
+   } // internal
+} // g3
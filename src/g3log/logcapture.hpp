@@ -10,10 +10,16 @@
 
 #include "g3log/loglevels.hpp"
 #include "g3log/crashhandler.hpp"
+#include "g3log/logstream.hpp"
+#include "g3log/logformat.hpp"
+#include "g3log/callsite.hpp"
+#include "g3log/attributes.hpp"
+#include "g3log/loglazy.hpp"
 
+#include <memory>
 #include <string>
-#include <sstream>
 #include <cstdarg>
+#include <cstdint>
 #include <csignal>
 #ifdef _MSC_VER
 # include <sal.h>
@@ -24,10 +30,13 @@
  * forwarded to background worker.
  * As a safety precaution: No memory allocated here will be moved into the background
  * worker in case of dynamic loaded library reasons
+ *
+ * All of it is G3_COLD: what a LOG call does after its level check is out of line and away
+ * from the hot code of the caller, see g3log/attributes.hpp
 */
 struct LogCapture {
    /// Called from crash handler when a fatal signal has occurred (SIGSEGV etc)
-   LogCapture(const LEVELS &level, g3::SignalType fatal_signal, const char *dump = nullptr);
+   G3_COLD LogCapture(const LEVELS &level, g3::SignalType fatal_signal, const char *dump = nullptr);
 
 
    /**
@@ -36,18 +45,32 @@ struct LogCapture {
     * @expression for CHECK calls
     * @fatal_signal for failed CHECK:SIGABRT or fatal signal caught in the signal handler
     */
-   LogCapture(const char* file, const int line, const char* function, 
+   G3_COLD LogCapture(const char* file, const int line, const char* function,
               const LEVELS& level, 
               const char* expression = "", 
               g3::SignalType fatal_signal = SIGABRT, 
               const char* dump = nullptr);
 
 
+   /**
+    * @site the static description of the LOG/CHECK call, declared by the macros in g3log.hpp
+    * @level INFO/DEBUG/WARNING/FATAL
+    * @expression for CHECK calls
+    * @fatal_signal for failed CHECK:SIGABRT or fatal signal caught in the signal handler
+    */
+   G3_COLD LogCapture(const g3::CallSite& site, const LEVELS& level,
+              const char* expression = "",
+              g3::SignalType fatal_signal = SIGABRT,
+              const char* dump = nullptr);
+
+
    // At destruction the message will be forwarded to the g3log worker.
    // In the case of dynamically (at runtime) loaded libraries, the important thing to know is that
    // all strings are copied, so the original are not destroyed at the receiving end, only the copy
-   virtual ~LogCapture() noexcept(false);
+   G3_COLD virtual ~LogCapture() noexcept(false);
 
+   LogCapture(const LogCapture&) = delete;
+   LogCapture& operator=(const LogCapture&) = delete;
 
 
 
@@ -58,21 +81,44 @@ struct LogCapture {
 #		define G3LOG_FORMAT_STRING __format_string
 #	endif
    
-    void capturef(G3LOG_FORMAT_STRING const char *printf_like_message, ...);
+    G3_COLD void capturef(G3LOG_FORMAT_STRING const char *printf_like_message, ...);
 #else
 #	define G3LOG_FORMAT_STRING
 
    // Use "-Wall" to generate warnings in case of illegal printf format.
    //      Ref:  http://www.unixwiz.net/techtips/gnu-c-attributes.html
-   [[gnu::format(printf, 2, 3)]] void capturef(G3LOG_FORMAT_STRING const char *printf_like_message, ...); // 2,3 ref:  http://www.codemaestro.com/reviews/18
+   [[gnu::format(printf, 2, 3)]] G3_COLD void capturef(G3LOG_FORMAT_STRING const char *printf_like_message, ...); // 2,3 ref:  http://www.codemaestro.com/reviews/18
 #endif
 
+   /// "{}" formatting used by LOGFMT, LOGFMT_IF and CHECKFMT. The format string comes
+   /// wrapped as a type by G3_FORMAT_STRING so that it is verified at compile time
+   template<typename FormatString, typename... Args>
+   G3_COLD void capturefmt(FormatString, const Args&... args) {
+      g3::internal::formatTo<FormatString>(stream(), args...);
+   }
+
+   /// the number of messages a rate limited call site suppressed before this one, see
+   /// LOG_EVERY_N. It is added to the end of the message
+   LogCapture& suppressed(uint64_t count) {
+      _suppressed = count;
+      return *this;
+   }
+
+   /// the callable of LOG_LAZY, its text is appended to the message by the LogWorker.
+   /// See g3log/loglazy.hpp
+   template<typename Render>
+   G3_COLD LogCapture& lazy(Render&& render) {
+      using Lazy = g3::internal::LazyTextOf<typename std::decay<Render>::type>;
+      _lazy = std::make_shared<Lazy>(std::forward<Render>(render));
+      return *this;
+   }
+
    /// prettifying API for this completely open struct
-   std::ostringstream &stream() {
-      return _stream;
+   g3::LogStream &stream() {
+      return *_stream;
    }
 
-   std::ostringstream _stream; // TODO replace std::ostringstream with self-defined class
+   g3::LogStream* _stream; // borrowed from the calling thread's cache, see g3::internal::acquireLogStream
    std::string _stack_trace;
    const char* _file;
    const int _line;
@@ -80,6 +126,9 @@ struct LogCapture {
    const LEVELS& _level;
    const char* _expression;
    const g3::SignalType _fatal_signal;
+   const g3::CallSite* _site = nullptr; // not set for the crash handler's messages
+   uint64_t _suppressed = 0;
+   std::shared_ptr<g3::internal::LazyText> _lazy; // set by LOG_LAZY
 
 };
 //} // g3
@@ -0,0 +1,103 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include <initializer_list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Diagnostic context of a thread: key/value fields, such as a request id, that are shown
+ * with every message the thread logs while they are in scope
+ *
+ *    g3::ScopedContext context {{"req", request.id()}, {"tenant", tenant}};
+ *    LOG(INFO) << "started"; // ... file->function:12] {req=42 tenant=acme} started
+ *
+ * The fields are not written into the messages. A ScopedContext makes an immutable LogContext
+ * with its fields and a pointer to the thread's LogContext before it, once, when it is
+ * created. A message takes a reference counted pointer to the thread's LogContext: one
+ * reference count increment per LOG call, none if the thread has no context. The fields are
+ * written out by the background worker, see LogMessage::context() and the log details
+ * formatting functions of LogMessage. */
+namespace g3 {
+   /// One field of a LogContext. The value is kept as text, a value that is not a string is
+   /// written with its operator<<
+   struct ContextField {
+      template <typename T>
+      ContextField(std::string field_key, const T& field_value)
+         : key(std::move(field_key)), value(toText(field_value)) {}
+
+      std::string key;
+      std::string value;
+
+    private:
+      template <typename T>
+      static std::string toText(const T& value) {
+         if constexpr (std::is_convertible<const T&, std::string_view>::value) {
+            return std::string(std::string_view(value));
+         } else {
+            std::ostringstream text;
+            text << value;
+            return text.str();
+         }
+      }
+   };
+
+
+   /// The context of a thread at one point: the fields of a ScopedContext and the context
+   /// that was in place before it. Immutable, so a message can share it with the thread
+   class LogContext {
+    public:
+      LogContext(std::shared_ptr<const LogContext> outer, std::vector<ContextField> fields)
+         : _outer(std::move(outer)), _fields(std::move(fields)) {}
+
+      /// the fields of the enclosing scopes first, the innermost last
+      std::vector<ContextField> fields() const;
+
+      /// "req=42 tenant=acme"
+      std::string toString() const;
+
+    private:
+      void appendTo(std::string& out) const;
+
+      const std::shared_ptr<const LogContext> _outer;
+      const std::vector<ContextField> _fields;
+   };
+   using LogContextPtr = std::shared_ptr<const LogContext>;
+
+
+   /// The calling thread's context, nullptr if it has none. Can be given to a ScopedContext in
+   /// another thread, e.g. the one that does the work of a request for it
+   LogContextPtr currentContext();
+
+
+   /** Adds fields to the calling thread's context for as long as it exists. The ScopedContexts
+    * of a thread nest: a message shows the fields of all of them, the outermost first.
+    * A ScopedContext must be destroyed by the thread that created it */
+   class ScopedContext {
+    public:
+      ScopedContext(std::initializer_list<ContextField> fields);
+
+      /// Makes 'context', e.g. the currentContext() of another thread, the calling thread's
+      /// context. The thread's own context is put back when the ScopedContext is destroyed
+      explicit ScopedContext(LogContextPtr context);
+      ~ScopedContext();
+
+      ScopedContext(const ScopedContext&) = delete;
+      ScopedContext& operator=(const ScopedContext&) = delete;
+
+    private:
+      LogContextPtr _context;
+      const LogContextPtr* _previous; // the thread's context before this one
+   };
+} // g3
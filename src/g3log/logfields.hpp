@@ -0,0 +1,152 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/** Typed key/value fields of a log message
+ *
+ *    LOG(INFO) << g3::kv("latency_us", 123) << g3::kv("path", path) << "done";
+ *
+ * A field is not written into the message text. It is kept with its type, in a compact
+ * record in the LogMessage (LogMessage::_fields), so that a sink that writes JSON or columns
+ * can take the values as they are, without parsing the text:
+ *
+ *    for (const g3::LogField& field : message.fields()) {
+ *       if (g3::LogField::Type::Int == field.type) { json.add(field.key, field.integer); }
+ *       ...
+ *    }
+ *
+ * The default text formatting, LogMessage::toString, writes the fields after the message
+ * text: "done latency_us=123 path=/index.html". */
+namespace g3 {
+   struct LogField {
+      enum class Type : char { Int = 'i', UInt = 'u', Double = 'd', Bool = 'b', String = 's' };
+
+      std::string_view key;
+      Type type = Type::Int;
+      // the value, in the member of its type
+      int64_t integer = 0;
+      uint64_t unsigned_integer = 0;
+      double floating = 0;
+      bool boolean = false;
+      std::string_view text;
+
+      /// the value as it is written by the default text formatting: "123", "0.25", "true"
+      std::string valueToString() const;
+   };
+
+
+   /// A field for LOG(...) << g3::kv(key, value). The value is an integer, a floating point
+   /// number, a bool, an enum or a string. Strings are copied into the message
+   template <typename T>
+   LogField kv(std::string_view key, const T& value) {
+      LogField field;
+      field.key = key;
+      if constexpr (std::is_same<T, bool>::value) {
+         field.type = LogField::Type::Bool;
+         field.boolean = value;
+      } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+         field.type = LogField::Type::Int;
+         field.integer = value;
+      } else if constexpr (std::is_integral<T>::value) {
+         field.type = LogField::Type::UInt;
+         field.unsigned_integer = value;
+      } else if constexpr (std::is_enum<T>::value) {
+         return kv(key, static_cast<typename std::underlying_type<T>::type>(value));
+      } else if constexpr (std::is_floating_point<T>::value) {
+         field.type = LogField::Type::Double;
+         field.floating = static_cast<double>(value);
+      } else if constexpr (std::is_same<typename std::decay<T>::type, const char*>::value
+                           || std::is_same<typename std::decay<T>::type, char*>::value) {
+         field.type = LogField::Type::String;
+         field.text = (nullptr == value) ? std::string_view() : std::string_view(value);
+      } else {
+         static_assert(std::is_convertible<const T&, std::string_view>::value,
+                       "g3::kv: the value must be an integer, floating point number, bool, enum or string");
+         field.type = LogField::Type::String;
+         field.text = std::string_view(value);
+      }
+      return field;
+   }
+
+
+   /** The fields of a message, read from its record. The record is
+    * per field: type tag (1 byte), key length (uint32_t), key, value. The value is 8 bytes for
+    * Int, UInt and Double, 1 byte for Bool and a uint32_t length and the characters for String */
+   class LogFields {
+    public:
+      class const_iterator {
+       public:
+         using iterator_category = std::input_iterator_tag;
+         using value_type = LogField;
+         using difference_type = std::ptrdiff_t;
+         using pointer = const LogField*;
+         using reference = const LogField&;
+
+         const_iterator(const char* read, const char* end) : _read(read), _end(end) {
+            next();
+         }
+
+         reference operator*() const {
+            return _field;
+         }
+         pointer operator->() const {
+            return &_field;
+         }
+         const_iterator& operator++() {
+            next();
+            return *this;
+         }
+         bool operator==(const const_iterator& other) const {
+            return _current == other._current;
+         }
+         bool operator!=(const const_iterator& other) const {
+            return _current != other._current;
+         }
+
+       private:
+         void next(); // reads the field at _read into _field, or moves to the end
+
+         const char* _read;
+         const char* _end;
+         const char* _current = nullptr; // where _field was read from, _end when done
+         LogField _field;
+      };
+
+      explicit LogFields(std::string_view record) : _record(record) {}
+
+      const_iterator begin() const {
+         return const_iterator(_record.data(), _record.data() + _record.size());
+      }
+      const_iterator end() const {
+         return const_iterator(_record.data() + _record.size(), _record.data() + _record.size());
+      }
+      bool empty() const {
+         return _record.empty();
+      }
+
+      /// "latency_us=123 path=/index.html"
+      std::string toString() const;
+
+    private:
+      std::string_view _record;
+   };
+
+
+   namespace internal {
+      /// Appends the field to a record, see LogFields
+      void appendField(std::string& record, const LogField& field);
+   } // internal
+} // g3
@@ -0,0 +1,385 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/logstream.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/** Compile time checked "{}" formatting used by LOGFMT, LOGFMT_IF and CHECKFMT
+ *
+ * The format string is parsed and verified against the argument types when compiling.
+ * A broken format string, or an argument that does not match its placeholder, is a
+ * compilation error (static_assert) instead of a runtime surprise like with printf.
+ *
+ * Supported syntax is a subset of std::format:
+ *   {}                 next argument, default formatting
+ *   {:[[fill]align][sign][#][0][width][.precision][type]}
+ *         align:       '<' left, '>' right, '^' center
+ *         sign:        '+' always, '-' only negative (default), ' ' space for positive
+ *         #:           0x, 0X, 0b, 0B or 0 prefix for integers
+ *         0:           pad numbers with zeros after the sign/prefix
+ *         precision:   digits for floating point values, max length for strings
+ *         type:        integers:       d x X o b B c
+ *                      floating point: f F e E g G a A
+ *                      strings, bool:  s
+ *                      pointers:       p
+ *   {{ and }}          literal '{' and '}'
+ *
+ * Explicit argument indexes ("{0}") and nested width/precision ("{:{}}") are not supported.
+ * Types that are not built in are written with their operator<< and only accept fill,
+ * alignment and width. Width counts bytes, not UTF-8 code points.
+ */
+namespace g3 {
+   namespace internal {
+
+      enum class FormatError {
+         None,
+         UnmatchedOpenBrace,
+         UnmatchedCloseBrace,
+         ArgumentIndexNotSupported,
+         InvalidSpec,
+         TooFewArguments,
+         TooManyArguments,
+         TypeMismatch,
+         FlagNotAllowed,
+         PrecisionNotAllowed
+      };
+
+      enum class ArgumentKind { Bool, Char, Signed, Unsigned, Floating, String, Pointer, Other };
+
+      struct FormatSpec {
+         char fill = ' ';
+         char align = 0;   // 0 means the default of the argument kind
+         char sign = 0;
+         bool alternate = false;
+         bool zero_pad = false;
+         int width = 0;
+         int precision = -1;
+         char type = 0;
+      };
+
+      /// the parsed format string with N placeholders. Literal text i is the text
+      /// in front of placeholder i, literal text N is the text after the last placeholder
+      template<size_t N>
+      struct ParsedFormat {
+         FormatError error = FormatError::None;
+         size_t literal_begin[N + 1] = {};
+         size_t literal_end[N + 1] = {};
+         FormatSpec specs[N + 1] = {};
+      };
+
+
+      constexpr bool isDigit(char c) {
+         return c >= '0' && c <= '9';
+      }
+
+      constexpr bool isAlign(char c) {
+         return c == '<' || c == '>' || c == '^';
+      }
+
+      constexpr FormatError parseSpec(std::string_view spec, FormatSpec& out) {
+         const int kMaxWidth = 4096;
+         const size_t size = spec.size();
+         size_t i = 0;
+         if (size >= 2 && isAlign(spec[1])) {
+            out.fill = spec[0];
+            out.align = spec[1];
+            i = 2;
+         } else if (size >= 1 && isAlign(spec[0])) {
+            out.align = spec[0];
+            i = 1;
+         }
+         if (i < size && (spec[i] == '+' || spec[i] == '-' || spec[i] == ' ')) {
+            out.sign = spec[i++];
+         }
+         if (i < size && spec[i] == '#') {
+            out.alternate = true;
+            ++i;
+         }
+         if (i < size && spec[i] == '0') {
+            out.zero_pad = true;
+            ++i;
+         }
+         while (i < size && isDigit(spec[i])) {
+            out.width = out.width * 10 + (spec[i++] - '0');
+            if (out.width > kMaxWidth) {
+               return FormatError::InvalidSpec;
+            }
+         }
+         if (i < size && spec[i] == '.') {
+            ++i;
+            if (i == size || !isDigit(spec[i])) {
+               return FormatError::InvalidSpec;
+            }
+            out.precision = 0;
+            while (i < size && isDigit(spec[i])) {
+               out.precision = out.precision * 10 + (spec[i++] - '0');
+               if (out.precision > kMaxWidth) {
+                  return FormatError::InvalidSpec;
+               }
+            }
+         }
+         if (i < size) {
+            out.type = spec[i++];
+         }
+         return (i == size) ? FormatError::None : FormatError::InvalidSpec;
+      }
+
+
+      template<size_t N>
+      constexpr ParsedFormat<N> parseFormat(std::string_view format) {
+         ParsedFormat<N> parsed{};
+         const size_t size = format.size();
+         size_t argument = 0;
+         size_t literal_start = 0;
+         size_t i = 0;
+         while (i < size) {
+            if (format[i] == '}') {
+               if (i + 1 < size && format[i + 1] == '}') {
+                  i += 2;
+                  continue;
+               }
+               parsed.error = FormatError::UnmatchedCloseBrace;
+               return parsed;
+            }
+            if (format[i] != '{') {
+               ++i;
+               continue;
+            }
+            if (i + 1 < size && format[i + 1] == '{') {
+               i += 2;
+               continue;
+            }
+
+            size_t close = i + 1;
+            while (close < size && format[close] != '}' && format[close] != '{') {
+               ++close;
+            }
+            if (close == size || format[close] == '{') {
+               parsed.error = FormatError::UnmatchedOpenBrace;
+               return parsed;
+            }
+
+            FormatSpec spec{};
+            const std::string_view inside = format.substr(i + 1, close - i - 1);
+            if (!inside.empty()) {
+               if (inside[0] != ':') {
+                  parsed.error = FormatError::ArgumentIndexNotSupported;
+                  return parsed;
+               }
+               const FormatError error = parseSpec(inside.substr(1), spec);
+               if (FormatError::None != error) {
+                  parsed.error = error;
+                  return parsed;
+               }
+            }
+            if (argument == N) {
+               parsed.error = FormatError::TooFewArguments;
+               return parsed;
+            }
+            parsed.literal_begin[argument] = literal_start;
+            parsed.literal_end[argument] = i;
+            parsed.specs[argument] = spec;
+            ++argument;
+            i = close + 1;
+            literal_start = i;
+         }
+
+         if (argument != N) {
+            parsed.error = FormatError::TooManyArguments;
+            return parsed;
+         }
+         parsed.literal_begin[N] = literal_start;
+         parsed.literal_end[N] = size;
+         return parsed;
+      }
+
+
+      template<typename T>
+      constexpr ArgumentKind argumentKind() {
+         using Type = std::remove_cv_t<std::remove_reference_t<T>>;
+         using Decayed = std::decay_t<Type>;
+         if constexpr (std::is_same_v<Type, bool>) {
+            return ArgumentKind::Bool;
+         } else if constexpr (std::is_same_v<Type, char>) {
+            return ArgumentKind::Char;
+         } else if constexpr (std::is_integral_v<Type>) {
+            return std::is_signed_v<Type> ? ArgumentKind::Signed : ArgumentKind::Unsigned;
+         } else if constexpr (std::is_floating_point_v<Type>) {
+            return ArgumentKind::Floating;
+         } else if constexpr (std::is_same_v<Type, std::string> || std::is_same_v<Type, std::string_view>
+                              || std::is_same_v<Decayed, const char*> || std::is_same_v<Decayed, char*>) {
+            return ArgumentKind::String;
+         } else if constexpr (std::is_pointer_v<Decayed> || std::is_null_pointer_v<Type>) {
+            return ArgumentKind::Pointer;
+         } else {
+            return ArgumentKind::Other;
+         }
+      }
+
+
+      constexpr bool isIntegerType(char type) {
+         return type == 'd' || type == 'x' || type == 'X' || type == 'o' || type == 'b' || type == 'B';
+      }
+
+      constexpr bool isFloatingType(char type) {
+         return type == 'f' || type == 'F' || type == 'e' || type == 'E'
+                || type == 'g' || type == 'G' || type == 'a' || type == 'A';
+      }
+
+      constexpr FormatError checkSpec(ArgumentKind kind, const FormatSpec& spec) {
+         const char type = spec.type;
+         bool numeric = false;
+         switch (kind) {
+            case ArgumentKind::Bool:
+               if (type != 0 && type != 's') return FormatError::TypeMismatch;
+               break;
+            case ArgumentKind::Char:
+               if (type != 0 && type != 'c' && !isIntegerType(type)) return FormatError::TypeMismatch;
+               numeric = isIntegerType(type);
+               break;
+            case ArgumentKind::Signed:
+            case ArgumentKind::Unsigned:
+               if (type != 0 && type != 'c' && !isIntegerType(type)) return FormatError::TypeMismatch;
+               numeric = (type != 'c');
+               break;
+            case ArgumentKind::Floating:
+               if (type != 0 && !isFloatingType(type)) return FormatError::TypeMismatch;
+               numeric = true;
+               break;
+            case ArgumentKind::String:
+               if (type != 0 && type != 's') return FormatError::TypeMismatch;
+               break;
+            case ArgumentKind::Pointer:
+               if (type != 0 && type != 'p') return FormatError::TypeMismatch;
+               break;
+            case ArgumentKind::Other:
+               if (type != 0) return FormatError::TypeMismatch;
+               break;
+         }
+         if (!numeric && (spec.sign != 0 || spec.zero_pad || spec.alternate)) {
+            return FormatError::FlagNotAllowed;
+         }
+         if (ArgumentKind::Floating == kind && spec.alternate) {
+            return FormatError::FlagNotAllowed;
+         }
+         if (spec.precision >= 0 && ArgumentKind::Floating != kind && ArgumentKind::String != kind) {
+            return FormatError::PrecisionNotAllowed;
+         }
+         return FormatError::None;
+      }
+
+      template<typename... Args, size_t N>
+      constexpr FormatError checkArguments(const ParsedFormat<N>& parsed) {
+         if (FormatError::None != parsed.error) {
+            return parsed.error;
+         }
+         const ArgumentKind kinds[] = {argumentKind<Args>()..., ArgumentKind::Other};
+         for (size_t i = 0; i < N; ++i) {
+            const FormatError error = checkSpec(kinds[i], parsed.specs[i]);
+            if (FormatError::None != error) {
+               return error;
+            }
+         }
+         return FormatError::None;
+      }
+
+
+
+      // The writers are not templates, they are shared by all LOGFMT calls. See logformat.cpp
+      void formatLiteral(LogStreamBuf& out, const char* begin, const char* end);
+      void formatBool(LogStreamBuf& out, bool value, const FormatSpec& spec);
+      void formatChar(LogStreamBuf& out, char value, const FormatSpec& spec);
+      void formatSigned(LogStreamBuf& out, long long value, const FormatSpec& spec);
+      void formatUnsigned(LogStreamBuf& out, unsigned long long value, const FormatSpec& spec);
+      void formatFloating(LogStreamBuf& out, double value, const FormatSpec& spec);
+      void formatString(LogStreamBuf& out, std::string_view value, const FormatSpec& spec);
+      void formatPointer(LogStreamBuf& out, uintptr_t value, const FormatSpec& spec);
+      /// pads what was written from 'start' to the width of the spec
+      void formatPadding(LogStreamBuf& out, size_t start, const FormatSpec& spec, char default_align);
+
+
+      template<typename T>
+      void formatArgument(LogStream& stream, const T& value, const FormatSpec& spec) {
+         constexpr ArgumentKind kind = argumentKind<T>();
+         if constexpr (ArgumentKind::Bool == kind) {
+            formatBool(stream.textBuffer(), value, spec);
+         } else if constexpr (ArgumentKind::Char == kind) {
+            formatChar(stream.textBuffer(), value, spec);
+         } else if constexpr (ArgumentKind::Signed == kind) {
+            formatSigned(stream.textBuffer(), static_cast<long long>(value), spec);
+         } else if constexpr (ArgumentKind::Unsigned == kind) {
+            formatUnsigned(stream.textBuffer(), static_cast<unsigned long long>(value), spec);
+         } else if constexpr (ArgumentKind::Floating == kind) {
+            formatFloating(stream.textBuffer(), static_cast<double>(value), spec);
+         } else if constexpr (ArgumentKind::String == kind) {
+            if constexpr (std::is_array_v<T>) {
+               formatString(stream.textBuffer(), std::string_view(value, strnlen(value, std::extent_v<T>)), spec);
+            } else if constexpr (std::is_pointer_v<T>) {
+               formatString(stream.textBuffer(), (nullptr == value) ? std::string_view("(null)") : std::string_view(value), spec);
+            } else {
+               formatString(stream.textBuffer(), std::string_view(value), spec);
+            }
+         } else if constexpr (ArgumentKind::Pointer == kind) {
+            if constexpr (std::is_null_pointer_v<T>) {
+               formatPointer(stream.textBuffer(), 0, spec);
+            } else {
+               formatPointer(stream.textBuffer(), reinterpret_cast<uintptr_t>(value), spec);
+            }
+         } else {
+            const size_t start = stream.textBuffer().size();
+            stream << value;
+            formatPadding(stream.textBuffer(), start, spec, '<');
+         }
+      }
+
+
+      /// Formats the arguments according to the format string given by the FormatString type,
+      /// see G3_FORMAT_STRING. Anything wrong with the format string is a compilation error
+      template<typename FormatString, typename... Args>
+      void formatTo(LogStream& stream, const Args&... args) {
+         constexpr size_t N = sizeof...(Args);
+         constexpr std::string_view format = FormatString::value();
+         static constexpr ParsedFormat<N> parsed = parseFormat<N>(format);
+         constexpr FormatError error = checkArguments<Args...>(parsed);
+
+         static_assert(FormatError::UnmatchedOpenBrace != error, "LOGFMT: '{' without matching '}'. Use \"{{\" for a literal '{'");
+         static_assert(FormatError::UnmatchedCloseBrace != error, "LOGFMT: '}' without matching '{'. Use \"}}\" for a literal '}'");
+         static_assert(FormatError::ArgumentIndexNotSupported != error, "LOGFMT: only automatic argument numbering \"{}\" is supported");
+         static_assert(FormatError::InvalidSpec != error, "LOGFMT: invalid format specification inside {:...}");
+         static_assert(FormatError::TooFewArguments != error, "LOGFMT: more {} placeholders than arguments");
+         static_assert(FormatError::TooManyArguments != error, "LOGFMT: more arguments than {} placeholders");
+         static_assert(FormatError::TypeMismatch != error, "LOGFMT: the presentation type does not match the argument type");
+         static_assert(FormatError::FlagNotAllowed != error, "LOGFMT: sign, '#' and '0' are only allowed for numbers ('#' only for integers)");
+         static_assert(FormatError::PrecisionNotAllowed != error, "LOGFMT: precision is only allowed for floating point and string arguments");
+
+         if constexpr (FormatError::None == error) {
+            const char* text = format.data();
+            size_t index = 0;
+            auto next = [&](const auto& value) {
+               formatLiteral(stream.textBuffer(), text + parsed.literal_begin[index], text + parsed.literal_end[index]);
+               formatArgument(stream, value, parsed.specs[index]);
+               ++index;
+            };
+            (next(args), ...);
+            formatLiteral(stream.textBuffer(), text + parsed.literal_begin[N], text + parsed.literal_end[N]);
+         }
+      }
+   } // internal
+} // g3
+
+
+/// Makes the string literal available as a type, so that it can be checked at compile time
+#define G3_FORMAT_STRING(format) \
+   [] { struct G3FormatString { static constexpr std::string_view value() { return format; } }; return G3FormatString{}; }()
@@ -0,0 +1,90 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include <exception>
+#include <locale>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/** The callable of a LOG_LAZY call
+ *
+ *    LOG_LAZY(DEBUG, [snapshot = table.summary()] { return render(snapshot); });
+ *
+ * The callable is moved into the LogMessage and called by the background worker, before the
+ * message is given to the sinks (see LogWorkerImpl::bgSave and LogMessage::materialize). Its
+ * text is appended to what was streamed: LOG_LAZY(INFO, ...) << "table: "
+ *
+ * Lifetime: the callable runs after the LOG call has returned, on another thread. It must own
+ * what it uses, capture by value or by move, never references to locals of the caller.
+ * It is called once per message, whatever the number of sinks.
+ *
+ * The code of the callable is in the binary that made the LOG_LAZY call. A dynamically loaded
+ * library can be unloaded while its messages are still in the queue to the worker, so for a
+ * call site that is not in the executable, or a FATAL message, the callable is called right
+ * away, by the LOG_LAZY call. See CallSite::referable */
+namespace g3 {
+   namespace internal {
+      class LazyText {
+       public:
+         virtual ~LazyText() = default;
+
+         /// calls the callable the first time, the same text is returned after that.
+         /// An exception from the callable is written into the text, it never gets to the worker
+         const std::string& text() {
+            std::call_once(_rendered, [this] {
+               try {
+                  _text = render();
+               } catch (const std::exception& error) {
+                  _text = std::string("[...LOG_LAZY exception: ") + error.what() + "...]";
+               } catch (...) {
+                  _text = "[...LOG_LAZY unknown exception...]";
+               }
+            });
+            return _text;
+         }
+
+       protected:
+         virtual std::string render() = 0;
+
+       private:
+         std::once_flag _rendered;
+         std::string _text;
+      };
+
+
+      /// The callable returns a std::string, a string_view or anything with an operator<<
+      template <typename Render>
+      class LazyTextOf : public LazyText {
+       public:
+         explicit LazyTextOf(Render render) : _render(std::move(render)) {}
+
+       private:
+         std::string render() override {
+            using Result = typename std::decay<decltype(_render())>::type;
+            if constexpr (std::is_same<Result, std::string>::value) {
+               return _render();
+            } else if constexpr (std::is_convertible<Result, std::string_view>::value) {
+               return std::string(std::string_view(_render()));
+            } else {
+               std::ostringstream text;
+               text.imbue(std::locale::classic()); // as the LogStream
+               text << _render();
+               return text.str();
+            }
+         }
+
+         Render _render;
+      };
+   } // internal
+} // g3
@@ -26,7 +26,13 @@
 #include <algorithm>
 #include <map>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
 #include <g3log/atomicbool.hpp>
+#include <g3log/attributes.hpp>
 
 // Levels for logging, made so that it would be easy to change, remove, add levels -- KjellKod
 struct LEVELS {
@@ -104,11 +110,16 @@ namespace g3 {
 } // g3
 
 
-const LEVELS 
-   G3LOG_DEBUG {g3::kDebugValue, {/*"DEBUG"*/"DBG"}},
-   INFO {g3::kInfoValue, {/*"INFO"*/"INF"}},
-   WARNING {g3::kWarningValue, {/*"WARNING"*/"WRN"}},
-   FATAL {g3::kFatalValue, {/*"FATAL"*/"FAT"}};
+const LEVELS G3LOG_DEBUG {g3::kDebugValue, {/*"DEBUG"*/"DBG"}},
+      INFO {g3::kInfoValue, {/*"INFO"*/"INF"}},
+      WARNING {g3::kWarningValue, {/*"WARNING"*/"WRN"}},
+      FATAL {g3::kFatalValue, {/*"FATAL"*/"FAT"}};
+
+
+// The lowest level that LOG calls are compiled for, see G3_MIN_LOG_LEVEL in Options.cmake
+#if !defined(G3_LOG_MIN_LEVEL)
+#define G3_LOG_MIN_LEVEL g3::kDebugValue
+#endif
 
 
 namespace g3 {
@@ -147,10 +158,104 @@ namespace g3 {
       /// helper function to tell the logger if a log message was fatal. If it is 
       /// it will force a shutdown after all log entries are saved to the sinks
       bool wasFatal(const LEVELS& level);
+
+      /** For the compile time G3_LOG_MIN_LEVEL only: the level expression of a LOG call is
+       * looked at once more, in unevaluated context, with the built-in level names standing
+       * for these declarations instead, see INTERNAL_COMPILED_IN in g3log/g3log.hpp. Their
+       * types carry the value. A lower level derives from the next higher one, so that e.g.
+       * 'ok ? INFO : WARNING' has the type of WARNING, the highest level it can be. An
+       * expression with any other level has the type LEVELS and is always compiled in */
+      template <int Value, typename Base>
+      struct LevelTag : Base {
+         static constexpr int kValue = Value;
+      };
+
+      namespace level_tags {
+         using Fatal = LevelTag<kFatalValue, LEVELS>;
+         using Warning = LevelTag<kWarningValue, Fatal>;
+         using Info = LevelTag<kInfoValue, Warning>;
+         using Debug = LevelTag<kDebugValue, Info>;
+
+         // declared only, never defined: not to be used outside of decltype
+         [[maybe_unused]] extern const Debug G3LOG_DEBUG;
+         [[maybe_unused]] extern const Info INFO;
+         [[maybe_unused]] extern const Warning WARNING;
+         [[maybe_unused]] extern const Fatal FATAL;
+      } // level_tags
+
+      /// false for a LevelTag below G3_LOG_MIN_LEVEL, the LOG calls at it are compiled away.
+      /// The value of any other level is only known at runtime, its LOG calls are compiled
+      template <typename Level, typename = void>
+      struct CompiledIn : std::true_type {};
+
+      template <typename Level>
+      struct CompiledIn<Level, std::void_t<decltype(Level::kValue)>>
+         : std::integral_constant<bool, (Level::kValue >= G3_LOG_MIN_LEVEL)> {};
    }
 
 #ifdef G3_DYNAMIC_LOGGING
-   // Only safe if done at initialization in a single-thread context
+   namespace internal {
+      /** The enabled status of the levels, for G3_DYNAMIC_LOGGING. The levels with a value in
+       * [0, kLevelTableSize) have their status in the table, indexed by the value, so that
+       * logLevel() is one relaxed load. Levels with other values are kept in a map behind a
+       * mutex, see logLevelOutsideTable. The names of the levels, for getAll() and
+       * to_string(), are kept apart from the table. All changes are made with a mutex held,
+       * so levels can be added and changed while other threads log */
+      const int kLevelTableSize = 4096;
+      enum LevelStatus : uint8_t {kLevelAbsent = 0, kLevelDisabled = 1, kLevelEnabled = 2};
+
+      /// DEBUG, INFO, WARNING and FATAL are enabled, all other levels are absent
+      constexpr uint8_t defaultLevelStatus(int value) {
+         return (value == kDebugValue || value == kInfoValue || value == kWarningValue || value == kFatalValue)
+                ? kLevelEnabled : kLevelAbsent;
+      }
+
+      struct LevelTable {
+         // constant initialized with the defaults: it is ready before any static initialization
+         template <size_t... Value>
+         constexpr explicit LevelTable(std::index_sequence<Value...>) : status{{defaultLevelStatus(static_cast<int>(Value))}...} {}
+
+         std::atomic<uint8_t> status[kLevelTableSize];
+      };
+      extern LevelTable g_level_table;
+
+      /// logLevel() of a level with a value outside of the table
+      bool logLevelOutsideTable(int value);
+
+      const int kNoThreadLevel = std::numeric_limits<int>::min();
+
+      /// The threshold of the calling thread's innermost ScopedThreadLevel, kNoThreadLevel if
+      /// it has none. 'inline': a constant initialized thread_local that every translation
+      /// unit can see is read directly, an extern one would be read through a function call
+      inline thread_local int t_thread_level = kNoThreadLevel;
+   } // internal
+
+
+   /** Overrides the enabled levels for the calling thread only, as long as it exists. The
+    * thread logs the levels at or above 'level' and no others, whatever their status in
+    * g3::log_levels. To trace one request from start to end, without enabling DEBUG for the
+    * whole process:
+    *    g3::ScopedThreadLevel trace(G3LOG_DEBUG);
+    *    handle(request); // its LOG(DEBUG) calls are logged, other threads' are not
+    * A guard can also raise the threshold, e.g. to quiet a noisy thread. Guards nest: the
+    * innermost one is used, the previous threshold is restored when it is destroyed */
+   class ScopedThreadLevel {
+    public:
+      explicit ScopedThreadLevel(const LEVELS& level) : _previous(internal::t_thread_level) {
+         internal::t_thread_level = level.value;
+      }
+      ~ScopedThreadLevel() {
+         internal::t_thread_level = _previous;
+      }
+      ScopedThreadLevel(const ScopedThreadLevel&) = delete;
+      ScopedThreadLevel& operator=(const ScopedThreadLevel&) = delete;
+
+    private:
+      int _previous;
+   };
+
+
+   // Safe at any time, also while other threads log
    namespace only_change_at_initialization {
 
       /// add a custom level - enabled or disabled
@@ -196,7 +301,24 @@ namespace g3 {
 } // log_levels
 
 #endif
-   /// Enabled status for the given logging level
-   bool logLevel(const LEVELS& level);
+   /// Enabled status for the given logging level. Always true without G3_DYNAMIC_LOGGING.
+   /// A level that was never added is disabled. A ScopedThreadLevel of the calling thread
+   /// decides before the status of the level does
+   inline bool logLevel(const LEVELS& level) {
+#ifdef G3_DYNAMIC_LOGGING
+      const int value = level.value;
+      const int thread_level = internal::t_thread_level;
+      if (G3_UNLIKELY(internal::kNoThreadLevel != thread_level)) {
+         return value >= thread_level;
+      }
+      if (G3_LIKELY(static_cast<unsigned>(value) < static_cast<unsigned>(internal::kLevelTableSize))) {
+         return internal::kLevelEnabled == internal::g_level_table.status[value].load(std::memory_order_relaxed);
+      }
+      return internal::logLevelOutsideTable(value);
+#else
+      (void)level;
+      return true;
+#endif
+   }
 
 } // g3
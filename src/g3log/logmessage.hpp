@@ -14,11 +14,19 @@
 #include "g3log/time.hpp"
 #include "g3log/moveoncopy.hpp"
 #include "g3log/crashhandler.hpp"
+#include "g3log/callsite.hpp"
+#include "g3log/logcontext.hpp"
+#include "g3log/logfields.hpp"
+#include "g3log/loglazy.hpp"
+#include "g3log/messagebuffer.hpp"
+#include "g3log/threadinfo.hpp"
 
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <thread>
 #include <memory>
+#include <vector>
 
 namespace g3 {
 
@@ -31,17 +39,28 @@ namespace g3 {
    * desired way.
    */
    struct LogMessage {
+      /// How the file, function and expression strings given at construction are kept
+      ///  Copy:      copied into one block owned by the message. Always safe.
+      ///  Reference: only referenced. The strings MUST outlive the message, which is true for
+      ///             __FILE__ and __PRETTY_FUNCTION__ literals as long as the library that
+      ///             logged them is not unloaded (dlclose) while the message is in flight
+      enum class Details { Copy, Reference };
+
       std::string file_path() const {
-         return _file_path;
+         return std::string(_file_path);
       }
       std::string file() const {
-         return _file;
+         return std::string(_file);
       }
       std::string line() const {
          return std::to_string(_line);
       }
       std::string function() const {
-         return _function;
+         return std::string(_function);
+      }
+      /// the function name without return type, parameters and namespaces, i.e. "Class::method"
+      std::string short_function() const {
+         return std::string(_short_function);
       }
       std::string level() const {
          return _level.text;
@@ -52,23 +71,63 @@ namespace g3 {
       std::string timestamp(const std::string& time_format = {internal::date_formatted + " " + internal::time_formatted}) const;
 
       std::string message() const  {
-         return _message;
+         materialize();
+         return _message.str();
       }
+      /// the message text, for changing it. It is moved out of the inline storage into a
+      /// std::string the first time, see g3::MessageBuffer::string()
       std::string& write() const {
+         materialize();
+         return _message.string();
+      }
+      /// the message text where it is, for appending to it without moving it out of the
+      /// inline storage. See g3::MessageBuffer
+      MessageBuffer& buffer() const {
+         materialize();
          return _message;
       }
 
+      /// Formats the deferred arguments, if any, into the message text, appends the text of a
+      /// LOG_LAZY callable and converts a raw G3_LOG_CLOCK_TSC time stamp to _timestamp.
+      /// Done by the LogWorker before the message is given to the sinks.
+      void materialize() const {
+         if (!_arguments.empty()) {
+            materializeArguments();
+         }
+         if (nullptr != _lazy) {
+            materializeLazy();
+         }
+         if (0 != _ticks) {
+            materializeTimestamp();
+         }
+      }
+
+      /// the typed g3::kv fields, see g3log/logfields.hpp
+      LogFields fields() const {
+         return LogFields(_fields);
+      }
+
       std::string expression() const {
-         return _expression;
+         return std::string(_expression);
       }
       bool wasFatal() const {
          return internal::wasFatal(_level);
       }
 
+      /// the operating system's id of the thread that logged, e.g. gettid() on Linux
       std::string threadID() const;
+      /// the name given to the thread that logged, see g3::setThreadName. Empty if none
+      std::string threadName() const {
+         return std::string(_thread_name);
+      }
+      /// the fields of the thread's g3::ScopedContext when it logged, "req=42 tenant=acme".
+      /// Empty if it had none. The fields are also in _context
+      std::string context() const {
+         return _context ? _context->toString() : std::string();
+      }
 
       void setExpression(const std::string expression) {
-         _expression = expression;
+         storeDetails(_file_path, _function, expression, Details::Copy);
       }
 
 
@@ -77,6 +136,25 @@ namespace g3 {
 
       LogMessage(std::string file, const int line, std::string function, const LEVELS level);
 
+      /// Builds the complete message in one go, used by the LOG/CHECK capture.
+      /// The text is copied, the file, function and expression are treated according to 'details'
+      LogMessage(const char* file, const int line, const char* function, const LEVELS& level,
+                 const char* expression, std::string_view text, Details details = Details::Copy);
+
+      /// Builds the complete message for a LOG/CHECK call site. The file and function strings
+      /// are referred to, not copied, if the call site allows it. See g3::CallSite
+      LogMessage(const CallSite& site, const LEVELS& level, const char* expression, std::string_view text);
+
+      /// Re-initialize a used message for a new log entry, the memory it already has is reused.
+      /// Used for messages from the LogMessage pool, see g3log/logmessagepool.hpp
+      void reuse(const CallSite& site, const LEVELS& level, const char* expression, std::string_view text);
+      void reuse(const char* file, const int line, const char* function, const LEVELS& level,
+                 const char* expression, std::string_view text, Details details);
+      /// As the copy constructor, but the memory this message already has is reused
+      void reuse(const LogMessage& other);
+      /// clears the content but keeps up to 'max_capacity' bytes of memory per string
+      void recycle(size_t max_capacity);
+
       explicit LogMessage(const std::string& fatalOsSignalCrashMessage);
       LogMessage(const LogMessage& other);
       LogMessage(LogMessage&& other);
@@ -84,6 +162,7 @@ namespace g3 {
 
 
       // helper log printing functions used by "toString()"
+      // splitFileName is no longer used by g3log, the file name is found at compile time (see g3::CallSite)
       static std::string splitFileName(const std::string& str);
       static std::string fatalSignalToString(const LogMessage& msg);
       // windows only: fatalExceptionToString
@@ -110,30 +189,70 @@ namespace g3 {
       // Complete access to the raw data in case the helper functions above
       // are not enough.
       //
+      // The string views point into _details or, with Details::Reference, to the
+      // caller's strings
       mutable LogDetailsFunc _logDetailsToStringFunc;
-      g3::high_resolution_time_point _timestamp;
+      mutable g3::high_resolution_time_point _timestamp;
+      mutable uint64_t _ticks; // with G3_LOG_CLOCK_TSC: the CPU counter, until converted to _timestamp
       std::thread::id _call_thread_id;
-      std::string _file;
-      std::string _file_path;
+      uint64_t _thread_id; // the operating system's thread id, see g3::internal::ThreadInfo
+      std::string_view _thread_name; // see g3::setThreadName
+      LogContextPtr _context; // shared with the thread, see g3log/logcontext.hpp
+      std::string _details; // file path, function and expression back to back: one allocation
+      std::string_view _file;
+      std::string_view _file_path;
       int _line;
-      std::string _function;
+      std::string_view _function;
+      std::string_view _short_function; // part of _function
       LEVELS _level;
-      std::string _expression; // only with content for CHECK(...) calls
-      mutable std::string _message;
+      std::string_view _expression; // only with content for CHECK(...) calls
+      mutable MessageBuffer _message; // inline up to G3_LOG_INLINE_MESSAGE_SIZE, see Options.cmake
+      mutable std::string _arguments; // deferred argument record, see g3::LogStream::setDeferred
+      std::string _fields; // g3::kv record, see g3::LogFields
+      mutable std::shared_ptr<internal::LazyText> _lazy; // LOG_LAZY callable, see g3log/loglazy.hpp
 
 
       friend void swap(LogMessage& first, LogMessage& second) {
          using std::swap; // enable ADL
+         const char* first_details = first._details.data();
+         const size_t first_details_size = first._details.size();
+         const char* second_details = second._details.data();
+         const size_t second_details_size = second._details.size();
+
          swap(first._timestamp, second._timestamp);
+         swap(first._ticks, second._ticks);
          swap(first._call_thread_id, second._call_thread_id);
+         swap(first._thread_id, second._thread_id);
+         swap(first._thread_name, second._thread_name);
+         swap(first._context, second._context);
+         swap(first._details, second._details);
          swap(first._file, second._file);
+         swap(first._file_path, second._file_path);
          swap(first._line, second._line);
          swap(first._function, second._function);
+         swap(first._short_function, second._short_function);
          swap(first._level, second._level);
          swap(first._expression, second._expression);
          swap(first._message, second._message);
+         swap(first._arguments, second._arguments);
+         swap(first._fields, second._fields);
+         swap(first._lazy, second._lazy);
+
+         // short (SSO) strings change address when swapped
+         first.relocateDetails(second_details, second_details_size);
+         second.relocateDetails(first_details, first_details_size);
       }
 
+    private:
+      void materializeArguments() const;
+      void materializeLazy() const;
+      void materializeTimestamp() const;
+      void stampTime();
+      void stampThread();
+      void storeDetails(std::string_view file_path, std::string_view function,
+                        std::string_view expression, Details details,
+                        const CallSite* site = nullptr);
+      void relocateDetails(const char* old_details, size_t old_size);
    };
 
  
@@ -154,5 +273,46 @@ namespace g3 {
 
    typedef MoveOnCopy<std::unique_ptr<FatalMessage>> FatalMessagePtr;
    typedef MoveOnCopy<std::unique_ptr<LogMessage>> LogMessagePtr;
+   namespace internal {
+      /// Disposes of the message a sink was given. With pooled set it goes back to the
+      /// LogMessage pool instead, see g3log/logmessagepool.hpp
+      struct LogMessageDeleter {
+         bool pooled = false;
+         void operator()(LogMessage* message) const;
+      };
+   } // internal
+
+   /// The message that is sent to the sinks. As any MoveOnCopy a copy takes the message
+   /// along, but it is held by pointer: the LogWorker can then hand out the message of the
+   /// LOG call itself, and with G3_LOG_MESSAGE_POOL the sink gives it back to the pool
+   template<>
+   struct MoveOnCopy<LogMessage> {
+      using Owner = std::unique_ptr<LogMessage, internal::LogMessageDeleter>;
+      mutable Owner _move_only;
+
+      explicit MoveOnCopy(LogMessage&& m) : _move_only(new LogMessage(std::move(m))) {}
+      explicit MoveOnCopy(Owner m) : _move_only(std::move(m)) {}
+      MoveOnCopy(MoveOnCopy const& t) : _move_only(std::move(t._move_only)) {}
+      MoveOnCopy(MoveOnCopy&& t) : _move_only(std::move(t._move_only)) {}
+
+      MoveOnCopy& operator=(MoveOnCopy const& other) {
+         _move_only = std::move(other._move_only);
+         return *this;
+      }
+
+      MoveOnCopy& operator=(MoveOnCopy&& other) {
+         _move_only = std::move(other._move_only);
+         return *this;
+      }
+
+      LogMessage& get() {
+         return *_move_only;
+      }
+
+      LogMessage release() {
+         return std::move(*_move_only);
+      }
+   };
    typedef MoveOnCopy<LogMessage> LogMessageMover;
+   typedef MoveOnCopy<std::vector<std::unique_ptr<LogMessage>>> LogMessageBatch;
 } // g3
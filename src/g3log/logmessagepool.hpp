@@ -0,0 +1,48 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/logmessage.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace g3 {
+
+   /// Statistics of the LogMessage pool, see g3::internal::acquireLogMessage
+   /// The counts of other threads are added in batches, so they can lag a little behind
+   struct LogMessagePoolStats {
+      uint64_t hits = 0;            // acquired messages that were recycled
+      uint64_t misses = 0;          // acquired messages that had to be allocated
+      uint64_t high_watermark = 0;  // the most messages that were acquired and not yet released at once
+      uint64_t pooled = 0;          // messages in the shared depot right now, ready to be recycled
+
+      double hitRate() const {
+         const uint64_t total = hits + misses;
+         return (0 == total) ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+      }
+   };
+
+   LogMessagePoolStats logMessagePoolStats();
+
+
+   namespace internal {
+      /** A LogMessage from the pool. It keeps the memory it had the last time it was used,
+       * so a thread that logs often will after a while not allocate at all. Re-initialize it with
+       * LogMessage::reuse(...)
+       *
+       * Every thread has its own free list. Released messages go to the releasing thread's list
+       * and, in batches, to a shared depot where the other threads fetch them from. With
+       * G3_LOG_MESSAGE_POOL the LOG calls acquire their messages here. The LogWorker makes the
+       * copies for the sinks in messages from here too, and the sinks release them when they are
+       * done with them, see g3::internal::LogMessageDeleter */
+      std::unique_ptr<LogMessage> acquireLogMessage();
+      void releaseLogMessage(std::unique_ptr<LogMessage> message);
+   } // internal
+} // g3
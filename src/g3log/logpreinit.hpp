@@ -0,0 +1,61 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/logmessage.hpp"
+#include "g3log/generated_definitions.hpp"
+
+#include <cstddef>
+#include <memory>
+
+// The messages and bytes of message text kept before g3::initializeLogging, see Options.cmake:
+// G3_PREINIT_MESSAGES and G3_PREINIT_BYTES
+#if !defined(G3_LOG_PREINIT_MESSAGES)
+#define G3_LOG_PREINIT_MESSAGES 256
+#endif
+#if !defined(G3_LOG_PREINIT_BYTES)
+#define G3_LOG_PREINIT_BYTES (64 * 1024)
+#endif
+
+/** The messages that are logged before the first g3::initializeLogging, e.g. by static
+ * initializers, are kept in a ring of G3_LOG_PREINIT_MESSAGES messages. When the ring is full
+ * the oldest message gives way to the new one. A message that would take the message text
+ * above G3_LOG_PREINIT_BYTES is dropped. Keeping a message costs a few atomic operations,
+ * no lock is taken.
+ *
+ * The first g3::initializeLogging gives the kept messages, oldest first, to the LogWorker as one
+ * batch, ahead of all later messages. If messages were dropped the batch starts with a WARNING
+ * that tells how many. If the process exits without logging being initialized the kept
+ * messages are written to std::cerr, as is done before a fatal message.
+ *
+ * Messages logged after the logging was shut down are not kept. */
+namespace g3 {
+   namespace internal {
+      const size_t kPreInitMessages = G3_LOG_PREINIT_MESSAGES;
+      const size_t kPreInitBytes = G3_LOG_PREINIT_BYTES;
+      static_assert(kPreInitMessages > 0, "G3_LOG_PREINIT_MESSAGES must be at least 1");
+
+      /// Keeps a message that is logged while the logging is not initialized.
+      /// @return nullptr if the message was kept or dropped. The message itself once the kept
+      ///         messages were replayed: the logging is initialized now, or was shut down
+      std::unique_ptr<LogMessage> keepPreInitMessage(std::unique_ptr<LogMessage> message);
+
+      /// Ends the keeping and takes the kept messages, oldest first. Called once, by the first
+      /// g3::initializeLogging. Empty at any later call
+      LogMessageBatch replayPreInitMessages();
+
+      /// Ends the keeping and writes the kept messages, if any, to std::cerr. For an exit or a
+      /// fatal event before the logging was initialized
+      void dumpPreInitMessages();
+
+      /// for test: discards the kept messages and keeps the messages logged from now on again,
+      /// as before the first g3::initializeLogging. Only while no other thread logs
+      void restartPreInitKeeping();
+   } // internal
+} // g3
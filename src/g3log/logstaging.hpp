@@ -0,0 +1,64 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/logmessage.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+/** Per thread staging of log messages, with G3_LOG_STAGING (USE_G3_LOG_STAGING in Options.cmake)
+ *
+ * Without staging every LOG call puts its message on the LogWorker queue by itself: one mutex
+ * lock, one condition variable notify and one std::function per message. With staging the
+ * messages of a thread are collected in a staging area that only that thread uses, and handed
+ * to the LogWorker as one batch (LogWorker::saveBatch) when one of the thresholds is reached:
+ *  - the number of staged messages
+ *  - the bytes of staged message text
+ *  - the time: the LogWorker thread collects the staging areas of all threads every
+ *    'max_delay', so the messages of a thread that went quiet are not held back longer
+ * The staged messages are also handed over when the thread exits, when the logging is shut
+ * down and before a fatal message. The order of the messages of one thread is kept. */
+namespace g3 {
+   struct StagingThresholds {
+      size_t max_messages = 64;
+      size_t max_bytes = 64 * 1024;
+      std::chrono::milliseconds max_delay {10};
+   };
+
+   /// Hands the staged messages of all threads to the LogWorker now
+   void flushStagedMessages();
+
+   namespace only_change_at_initialization {
+      /// Sets the thresholds of the staging areas. The max_delay is used by LogWorkers
+      /// created after this call
+      void setStagingThresholds(const StagingThresholds& thresholds);
+   }
+   StagingThresholds stagingThresholds();
+
+   namespace internal {
+      /// Where a staging area is handed over to
+      using BatchPush = std::function<void(LogMessageBatch)>;
+
+      /// Adds the message to the calling thread's staging area. If a threshold is reached the
+      /// area is handed to the LogWorker
+      void stageMessage(std::unique_ptr<LogMessage> message);
+
+      /// Hands the staging areas of all threads to the LogWorker. With 'fatal' no lock is waited
+      /// for: an area that is in use, e.g. by a thread that crashed while staging, is skipped
+      void flushAllStagedMessages(bool fatal = false);
+
+      /// As above, but the staging areas are handed to 'push'. Used by the LogWorker thread
+      /// which puts them on its own queue and not on the one of the initialized logger.
+      /// Does nothing, takes no lock, if no message was staged since the last collection
+      void collectStagedMessages(const BatchPush& push);
+   } // internal
+} // g3
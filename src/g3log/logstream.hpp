@@ -0,0 +1,357 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/hexdump.hpp"
+#include "g3log/logfields.hpp"
+#include "g3log/messagebuffer.hpp"
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+namespace g3 {
+   namespace internal {
+
+      /** Growable character buffer that backs a g3::LogStream.
+       * The put area is the whole (reused) allocation so that the std::streambuf
+       * virtual calls only happen when the buffer must grow. Content is never
+       * null terminated until c_str() is asked for. */
+      class LogStreamBuf : public std::streambuf {
+       public:
+         LogStreamBuf();
+         LogStreamBuf(const LogStreamBuf&) = delete;
+         LogStreamBuf& operator=(const LogStreamBuf&) = delete;
+
+         /// drop the content but keep the capacity for the next log call
+         void reset();
+
+         const char* c_str();
+         size_t size() const {
+            return static_cast<size_t>(pptr() - pbase());
+         }
+
+         void append(const char* data, size_t count) {
+            if (static_cast<size_t>(epptr() - pptr()) < count) {
+               grow(count);
+            }
+            std::memcpy(pptr(), data, count);
+            advance(count);
+         }
+
+         /// @return at least 'count' writable bytes at the end of the buffer
+         ///         use @ref commit to tell how many of them that were used
+         char* reserve(size_t count) {
+            if (static_cast<size_t>(epptr() - pptr()) < count) {
+               grow(count);
+            }
+            return pptr();
+         }
+
+         /// the number of bytes that can be written without growing the buffer
+         size_t available() const {
+            return static_cast<size_t>(epptr() - pptr());
+         }
+
+         void commit(size_t count) {
+            advance(count);
+         }
+
+         /// direct access to already written content, used to patch the deferred record
+         char* data() {
+            return pbase();
+         }
+
+       protected:
+         int_type overflow(int_type ch) override;
+         std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+       private:
+         void grow(size_t extra);
+         void advance(size_t count);
+
+         std::string _buffer;
+      };
+
+
+
+      /** The tags of a deferred argument record, see @ref LogStream::setDeferred
+       * Text:     uint32_t length + the characters. Already formatted text
+       * Signed:   int64_t
+       * Unsigned: uint64_t
+       * Floating: int8_t precision + double
+       * HexDump:  uint64_t total + uint32_t size + the bytes, see g3log/hexdump.hpp */
+      enum class ArgumentTag : char { Text = 'T', Signed = 'i', Unsigned = 'u', Floating = 'd', HexDump = 'x' };
+
+      /// formats a deferred argument record, as produced by a LogStream, and appends it to 'out'
+      void formatArguments(std::string_view record, MessageBuffer& out);
+   } // internal
+
+
+
+   /** The stream behind LOG(...) << ... calls.
+    * It is a std::ostream so all user defined operator<< keep working, but the common
+    * types (strings, characters, integers and floating point values) are written straight
+    * into the buffer without going through the locale facets of the std::ostream, as long
+    * as no formatting manipulators (width, base, showpos etc) are active.
+    *
+    * The streams are cached per thread and reused between log calls, see
+    * @ref g3::internal::acquireLogStream
+    *
+    * A deferred stream (see @ref setDeferred) does not format the integer and floating point
+    * values at all. They are kept as raw bytes in a compact record which is formatted later,
+    * on the LogWorker thread, by @ref g3::internal::formatArguments. Everything that cannot be
+    * deferred is formatted as usual and stored in the record as text. */
+   class LogStream : public std::ostream {
+    public:
+      LogStream();
+      LogStream(const LogStream&) = delete;
+      LogStream& operator=(const LogStream&) = delete;
+
+      /// clear content and restore the default formatting state
+      void reset();
+
+      /// must be set right after @ref reset, before anything is written
+      void setDeferred(bool deferred) {
+         _deferred = deferred;
+      }
+      bool deferred() const {
+         return _deferred;
+      }
+
+      /// the formatted text. Only for streams that are not deferred
+      const char* c_str() {
+         return _buf.c_str();
+      }
+      size_t size() const {
+         return _buf.size();
+      }
+
+      /// the deferred argument record. Only for deferred streams
+      std::string_view arguments() {
+         closeText();
+         return std::string_view(_buf.data(), _buf.size());
+      }
+
+      /// the record of the g3::kv fields, see g3log/logfields.hpp. Kept apart from the text
+      std::string_view fields() const {
+         return _fields;
+      }
+
+      /// raw access for writers that produce text themselves, such as the LOGFMT formatting.
+      /// Also for a deferred stream everything written to it is treated as text
+      internal::LogStreamBuf& textBuffer() {
+         openText();
+         return _buf;
+      }
+
+
+      /// a typed field, LOG(INFO) << g3::kv("latency_us", 123). Not written to the text
+      LogStream& operator<<(const LogField& field) {
+         internal::appendField(_fields, field);
+         return *this;
+      }
+
+      /// a hex dump, LOG(INFO) << g3::hexdump(data, size). A deferred stream only copies the
+      /// bytes, the dump is written when the record is formatted
+      LogStream& operator<<(const HexDump& dump);
+
+      LogStream& operator<<(const char* value);
+      LogStream& operator<<(const std::string& value) {
+         return write_text(value.data(), value.size());
+      }
+      LogStream& operator<<(std::string_view value) {
+         return write_text(value.data(), value.size());
+      }
+      template<size_t N>
+      LogStream& operator<<(const char (&value)[N]) {
+         // literals are nearly always shorter than the array, but a char array might not be
+         return write_text(value, strnlen(value, N));
+      }
+
+      LogStream& operator<<(char value) {
+         openText();
+         if (0 == width()) {
+            _buf.append(&value, 1);
+            return *this;
+         }
+         static_cast<std::ostream&>(*this) << value;
+         return *this;
+      }
+
+      LogStream& operator<<(short value) { return write_integer(value); }
+      LogStream& operator<<(unsigned short value) { return write_integer(value); }
+      LogStream& operator<<(int value) { return write_integer(value); }
+      LogStream& operator<<(unsigned int value) { return write_integer(value); }
+      LogStream& operator<<(long value) { return write_integer(value); }
+      LogStream& operator<<(unsigned long value) { return write_integer(value); }
+      LogStream& operator<<(long long value) { return write_integer(value); }
+      LogStream& operator<<(unsigned long long value) { return write_integer(value); }
+      LogStream& operator<<(float value) { return write_floating(value); }
+      LogStream& operator<<(double value) { return write_floating(value); }
+
+
+      // manipulators such as std::endl, std::hex, std::boolalpha
+      LogStream& operator<<(std::ostream& (*manipulator)(std::ostream&)) {
+         openText();
+         manipulator(*this);
+         return *this;
+      }
+      LogStream& operator<<(std::ios_base& (*manipulator)(std::ios_base&)) {
+         manipulator(*this);
+         return *this;
+      }
+      LogStream& operator<<(std::basic_ios<char>& (*manipulator)(std::basic_ios<char>&)) {
+         manipulator(*this);
+         return *this;
+      }
+
+      /// everything else (user types, std::setw, pointers ...) goes through std::ostream
+      /// the return type is kept as LogStream& so that the fast paths above are still
+      /// used for the remaining part of the statement
+      template<typename T>
+      LogStream& operator<<(const T& value) {
+         openText();
+         static_cast<std::ostream&>(*this) << value;
+         return *this;
+      }
+
+    private:
+      // fast path is only taken when the std::ostream would produce exactly the same output
+      bool hasDefaultIntegerFormat() const {
+         const auto kModifiers = std::ios_base::basefield | std::ios_base::showpos | std::ios_base::showbase;
+         return (0 == width() && ((flags() & kModifiers) == std::ios_base::dec || 0 == (flags() & kModifiers)));
+      }
+
+      bool hasDefaultFloatingFormat() const {
+         const auto kModifiers = std::ios_base::floatfield | std::ios_base::showpos
+                                 | std::ios_base::showpoint | std::ios_base::uppercase;
+         return (0 == width() && 0 == (flags() & kModifiers));
+      }
+
+      // Text in a deferred record is stored as one Text entry per run of formatted text.
+      // The length of the open entry is only written when a binary value follows, or at the end
+      void openText() {
+         if (_deferred && kNoText == _text_start) {
+            char* out = _buf.reserve(kTextHeaderSize);
+            out[0] = static_cast<char>(internal::ArgumentTag::Text);
+            _buf.commit(kTextHeaderSize);
+            _text_start = _buf.size();
+         }
+      }
+
+      void closeText() {
+         if (kNoText != _text_start) {
+            const auto length = static_cast<uint32_t>(_buf.size() - _text_start);
+            std::memcpy(_buf.data() + _text_start - sizeof(length), &length, sizeof(length));
+            _text_start = kNoText;
+         }
+      }
+
+      template<typename Stored>
+      void write_deferred(internal::ArgumentTag tag, Stored value) {
+         closeText();
+         char* out = _buf.reserve(1 + sizeof(Stored));
+         out[0] = static_cast<char>(tag);
+         std::memcpy(out + 1, &value, sizeof(Stored));
+         _buf.commit(1 + sizeof(Stored));
+      }
+
+      LogStream& write_text(const char* value, size_t count) {
+         openText();
+         if (0 == width()) {
+            _buf.append(value, count);
+            return *this;
+         }
+         static_cast<std::ostream&>(*this) << std::string_view(value, count);
+         return *this;
+      }
+
+      template<typename Integer>
+      LogStream& write_integer(Integer value) {
+         if (_deferred && hasDefaultIntegerFormat()) {
+            if (std::is_signed<Integer>::value) {
+               write_deferred(internal::ArgumentTag::Signed, static_cast<int64_t>(value));
+            } else {
+               write_deferred(internal::ArgumentTag::Unsigned, static_cast<uint64_t>(value));
+            }
+            return *this;
+         }
+         openText();
+         if (hasDefaultIntegerFormat()) {
+            static const size_t kMaxDigits = 24; // 20 digits for uint64 + sign
+            char* out = _buf.reserve(kMaxDigits);
+            auto result = std::to_chars(out, out + kMaxDigits, value);
+            _buf.commit(static_cast<size_t>(result.ptr - out));
+            return *this;
+         }
+         static_cast<std::ostream&>(*this) << value;
+         return *this;
+      }
+
+      template<typename Floating>
+      LogStream& write_floating(Floating value) {
+#if defined(__cpp_lib_to_chars)
+         // std::ostream default for floating point is printf's "%.*g" with precision(),
+         // which is exactly what std::chars_format::general gives
+         if (hasDefaultFloatingFormat()) {
+            static const size_t kMaxChars = 64;
+            const auto digits = static_cast<int>(precision());
+            if (_deferred && digits >= 0 && digits < 32) {
+               // a float converted to double is the same value, so it prints the same
+               closeText();
+               char* out = _buf.reserve(1 + 1 + sizeof(double));
+               out[0] = static_cast<char>(internal::ArgumentTag::Floating);
+               out[1] = static_cast<char>(digits);
+               const double stored = value;
+               std::memcpy(out + 2, &stored, sizeof(stored));
+               _buf.commit(1 + 1 + sizeof(double));
+               return *this;
+            }
+            openText();
+            if (digits >= 0 && digits < 32) {
+               char* out = _buf.reserve(kMaxChars);
+               auto result = std::to_chars(out, out + kMaxChars, value, std::chars_format::general, digits);
+               if (std::errc() == result.ec) {
+                  _buf.commit(static_cast<size_t>(result.ptr - out));
+                  return *this;
+               }
+            }
+         }
+#endif
+         openText();
+         static_cast<std::ostream&>(*this) << value;
+         return *this;
+      }
+
+      static constexpr size_t kTextHeaderSize = 1 + sizeof(uint32_t);
+      static constexpr size_t kNoText = static_cast<size_t>(-1);
+
+      internal::LogStreamBuf _buf;
+      std::string _fields; // the g3::kv record
+      bool _deferred = false;
+      size_t _text_start = kNoText; // start of the open Text entry's characters, if any
+   };
+
+
+
+   namespace internal {
+      /** Borrow a LogStream from the calling thread's cache. The stream is reset and ready to use.
+       * A LOG call made while another LOG call on the same thread is still capturing
+       * (e.g. from inside a user defined operator<<) gets its own stream.
+       * Every acquired stream must be given back with @ref releaseLogStream */
+      LogStream* acquireLogStream();
+      void releaseLogStream(LogStream* stream);
+   } // internal
+} // g3
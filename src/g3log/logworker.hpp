@@ -16,6 +16,7 @@
 #include "g3log/sinkhandle.hpp"
 #include "g3log/filesink.hpp"
 #include "g3log/logmessage.hpp"
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -31,12 +32,14 @@ namespace g3 {
    struct LogWorkerImpl final {
       typedef std::shared_ptr<g3::internal::SinkWrapper> SinkWrapperPtr;
       std::vector<SinkWrapperPtr> _sinks; // one sink produces one thread
+      std::atomic<bool> _collect_staged {false}; // only the initialized logger collects, see g3log/logstaging.hpp
       std::unique_ptr<kjellkod::Active> _bg; // do not change declaration order. _bg must be destroyed before sinks
 
       LogWorkerImpl();
       ~LogWorkerImpl() = default;
 
       void bgSave(LogMessagePtr msgPtr);
+      void bgSaveBatch(LogMessageBatch batch);
       void bgFatal(FatalMessagePtr msgPtr);
 
       LogWorkerImpl(const LogWorkerImpl&) = delete;
@@ -194,6 +197,15 @@ namespace g3 {
       /// pushes in background thread (asynchronously) input messages to log file
       void save(LogMessagePtr entry);
 
+      /// internal:
+      /// as save, for several messages with one hand-over to the background thread
+      void saveBatch(LogMessageBatch entries);
+
+      /// internal:
+      /// with G3_LOG_STAGING the background thread collects the staged messages of all threads
+      /// while this is enabled. Enabled by initializeLogging, disabled by shutDownLogging
+      void setStagingCollection(bool enabled);
+
       /// internal:
       //  pushes a fatal message on the queue, this is the last message to be processed
       /// this way it's ensured that all existing entries were flushed before 'fatal'
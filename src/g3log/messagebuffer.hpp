@@ -0,0 +1,192 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/generated_definitions.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// The inline capacity of the message text, in bytes, see Options.cmake: G3_INLINE_MESSAGE_SIZE
+#if !defined(G3_LOG_INLINE_MESSAGE_SIZE)
+#define G3_LOG_INLINE_MESSAGE_SIZE 256
+#endif
+
+namespace g3 {
+
+   /** The text of a LogMessage. A text that fits in G3_LOG_INLINE_MESSAGE_SIZE bytes
+    * (terminating zero included) is kept inside the object itself, only a longer text is
+    * put on the heap, in a std::string. Most log entries are short, so most messages do not
+    * allocate at all.
+    *
+    * string() gives that std::string, the inline text is moved into it first. It is what
+    * LogMessage::write() returns to the sinks, so they have the complete std::string API.
+    * The text is always zero terminated. */
+   class MessageBuffer {
+    public:
+      static constexpr size_t kInlineSize = G3_LOG_INLINE_MESSAGE_SIZE;
+      static_assert(kInlineSize > 0, "G3_LOG_INLINE_MESSAGE_SIZE must at least fit the terminating zero");
+
+      MessageBuffer() noexcept : _size(0), _is_inline(true) {
+         _inline[0] = '\0';
+      }
+      MessageBuffer(std::string_view text) : MessageBuffer() {
+         append(text.data(), text.size());
+      }
+      MessageBuffer(const char* text) : MessageBuffer(std::string_view(text)) {}
+      MessageBuffer(const std::string& text) : MessageBuffer(std::string_view(text)) {}
+      MessageBuffer(const MessageBuffer& other) : MessageBuffer() {
+         append(other.data(), other.size());
+      }
+      MessageBuffer(MessageBuffer&& other) noexcept;
+      ~MessageBuffer() = default;
+
+      MessageBuffer& operator=(const MessageBuffer& other) {
+         return (this == &other) ? *this : assign(other.data(), other.size());
+      }
+      MessageBuffer& operator=(MessageBuffer&& other) noexcept;
+      MessageBuffer& operator=(std::string_view text) {
+         return assign(text.data(), text.size());
+      }
+
+      const char* data() const noexcept { return _is_inline ? _inline : _heap.data(); }
+      char* data() noexcept { return _is_inline ? _inline : &_heap[0]; }
+      const char* c_str() const noexcept { return data(); }
+      size_t size() const noexcept { return _is_inline ? _size : _heap.size(); }
+      size_t length() const noexcept { return size(); }
+      bool empty() const noexcept { return 0 == size(); }
+      /// the number of characters that fit without an allocation
+      size_t capacity() const noexcept { return _is_inline ? kInlineSize - 1 : _heap.capacity(); }
+      /// true as long as the text has not outgrown the inline storage, nor was asked for as string()
+      bool isInline() const noexcept { return _is_inline; }
+
+      const char* begin() const noexcept { return data(); }
+      const char* end() const noexcept { return data() + size(); }
+      char& operator[](size_t index) noexcept { return data()[index]; }
+      const char& operator[](size_t index) const noexcept { return data()[index]; }
+
+      /// The text as a std::string, for the parts of its API that are not here. From now on
+      /// the text is kept in it: the reference stays valid as long as the buffer is not
+      /// moved from, swapped or shrunk
+      std::string& string() {
+         if (_is_inline) {
+            spill(_size);
+         }
+         return _heap;
+      }
+
+      /// clears the text, an allocated buffer is kept
+      void clear() noexcept {
+         if (_is_inline) {
+            _size = 0;
+            _inline[0] = '\0';
+         } else {
+            _heap.clear();
+         }
+      }
+
+      /// goes back to the inline storage if more than 'max_capacity' was allocated
+      void shrink(size_t max_capacity) noexcept {
+         if (!_is_inline && _heap.capacity() > max_capacity) {
+            std::string().swap(_heap);
+            _is_inline = true;
+         }
+         clear();
+      }
+
+      void reserve(size_t capacity) {
+         if (!_is_inline) {
+            _heap.reserve(capacity);
+         } else if (capacity > kInlineSize - 1) {
+            spill(grownCapacity(capacity));
+         }
+      }
+
+      MessageBuffer& append(const char* text, size_t count) {
+         if (!_is_inline) {
+            _heap.append(text, count);
+         } else if (_size + count <= kInlineSize - 1) {
+            std::memcpy(_inline + _size, text, count);
+            _size += count;
+            _inline[_size] = '\0';
+         } else {
+            spill(grownCapacity(_size + count));
+            _heap.append(text, count);
+         }
+         return *this;
+      }
+      MessageBuffer& append(std::string_view text) { return append(text.data(), text.size()); }
+      MessageBuffer& append(const std::string& text) { return append(text.data(), text.size()); }
+      MessageBuffer& append(const char* text) { return append(text, std::strlen(text)); }
+      MessageBuffer& append(const MessageBuffer& text) { return append(text.data(), text.size()); }
+      MessageBuffer& append(size_t count, char c);
+
+      MessageBuffer& assign(const char* text, size_t count);
+      MessageBuffer& assign(std::string_view text) { return assign(text.data(), text.size()); }
+
+      void push_back(char c) { append(&c, 1); }
+      MessageBuffer& operator+=(std::string_view text) { return append(text.data(), text.size()); }
+      MessageBuffer& operator+=(const char* text) { return append(text); }
+      MessageBuffer& operator+=(char c) { return append(&c, 1); }
+
+      std::string str() const { return std::string(data(), size()); }
+      operator std::string() const { return str(); }
+      operator std::string_view() const noexcept { return std::string_view(data(), size()); }
+
+      friend void swap(MessageBuffer& first, MessageBuffer& second) noexcept {
+         MessageBuffer temporary(std::move(first));
+         first = std::move(second);
+         second = std::move(temporary);
+      }
+
+      friend bool operator==(const MessageBuffer& buffer, std::string_view text) noexcept {
+         return std::string_view(buffer) == text;
+      }
+      friend bool operator==(std::string_view text, const MessageBuffer& buffer) noexcept {
+         return std::string_view(buffer) == text;
+      }
+      friend bool operator!=(const MessageBuffer& buffer, std::string_view text) noexcept {
+         return !(buffer == text);
+      }
+      friend bool operator!=(std::string_view text, const MessageBuffer& buffer) noexcept {
+         return !(buffer == text);
+      }
+      friend std::ostream& operator<<(std::ostream& out, const MessageBuffer& buffer) {
+         return out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      }
+      friend std::string operator+(const std::string& text, const MessageBuffer& buffer) {
+         return std::string(text).append(buffer.data(), buffer.size());
+      }
+      friend std::string operator+(const MessageBuffer& buffer, const std::string& text) {
+         return buffer.str().append(text);
+      }
+      friend std::string operator+(const MessageBuffer& buffer, char c) {
+         return buffer.str().append(1, c);
+      }
+
+    private:
+      /// moves the inline text to _heap, with room for at least 'capacity' characters
+      void spill(size_t capacity);
+
+      // at least doubles the inline capacity, so that appending a character at a time after
+      // the spill does not reallocate every time
+      static size_t grownCapacity(size_t capacity) noexcept {
+         const size_t doubled = 2 * (kInlineSize - 1);
+         return (capacity < doubled) ? doubled : capacity;
+      }
+
+      std::string _heap; // the text once it outgrew the inline storage
+      size_t _size; // of the inline text
+      bool _is_inline;
+      char _inline[kInlineSize];
+   };
+} // g3
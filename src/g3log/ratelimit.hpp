@@ -0,0 +1,119 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/attributes.hpp"
+#include "g3log/callsite.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+/** The per call site counters of the rate limited LOG calls in g3log.hpp:
+ * LOG_EVERY_N, LOG_FIRST_N, LOG_EVERY_T and LOG_EVERY_N_IF
+ *
+ * Each of these calls declares a static LimitedCallSite, a g3::CallSite with the counters of
+ * its limit. It is constant initialized like the CallSite. The counters are relaxed atomics:
+ * the calls can be made from any thread, and a message that is not logged costs one relaxed
+ * atomic operation, a load for LOG_FIRST_N and an increment for the others. LOG_EVERY_T also
+ * reads a coarse clock and loads the time of the next message, see EveryT.
+ * A message that is logged after some were suppressed tells how many, e.g.
+ * "disk full (suppressed 12345 since last)" */
+namespace g3 {
+   namespace internal {
+      /// The decision of a rate limited call site. Converts to true if the message is skipped
+      struct Sample {
+         bool skip = true;
+         uint64_t suppressed = 0; // since the last message that was logged
+
+         explicit operator bool() const {
+            return skip;
+         }
+      };
+
+
+      /// Logs the 1st, the n+1th, the 2n+1th ... message. Every message with n <= 1
+      struct EveryN {
+         Sample sample(uint64_t n) const {
+            const uint64_t count = _count.fetch_add(1, std::memory_order_relaxed);
+            if (n <= 1) {
+               return Sample{false, 0};
+            }
+            if (G3_LIKELY(0 != count % n)) {
+               return Sample{};
+            }
+            return Sample{false, (0 == count) ? 0 : n - 1};
+         }
+
+         mutable std::atomic<uint64_t> _count{0};
+      };
+
+
+      /// Logs the first n messages. After that a message costs a load, not an increment: the
+      /// counter is not written any more, so the call sites of many threads do not fight over it
+      struct FirstN {
+         Sample sample(uint64_t n) const {
+            if (G3_LIKELY(_count.load(std::memory_order_relaxed) >= n)) {
+               return Sample{};
+            }
+            const bool skip = _count.fetch_add(1, std::memory_order_relaxed) >= n;
+            return Sample{skip, 0};
+         }
+
+         mutable std::atomic<uint64_t> _count{0};
+      };
+
+
+      /// Monotonic nanoseconds for EveryT. On Linux from CLOCK_MONOTONIC_COARSE, which is read from
+      /// the vDSO in a few nanoseconds, far less than a full clock read. Its resolution is the
+      /// scheduler tick, 1-4 ms, so a shorter period is rounded up to it
+      inline int64_t coarseSteadyNanoseconds() {
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+         timespec now;
+         if (0 == clock_gettime(CLOCK_MONOTONIC_COARSE, &now)) {
+            return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+         }
+#endif
+         using namespace std::chrono;
+         return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+      }
+
+
+      /// Logs at most one message per 'seconds'. The first message is always logged.
+      /// When the time is up the threads race for the next message, only one of them wins.
+      /// A suppressed message costs a coarse clock read, a relaxed load and one relaxed increment
+      struct EveryT {
+         Sample sample(double seconds) const {
+            const int64_t now = coarseSteadyNanoseconds();
+            int64_t next = _next.load(std::memory_order_relaxed);
+            if (G3_LIKELY(now < next)
+                || !_next.compare_exchange_strong(next, now + static_cast<int64_t>(seconds * 1e9), std::memory_order_relaxed)) {
+               _suppressed.fetch_add(1, std::memory_order_relaxed);
+               return Sample{};
+            }
+            return Sample{false, _suppressed.exchange(0, std::memory_order_relaxed)};
+         }
+
+         mutable std::atomic<int64_t> _next{0}; // coarseSteadyNanoseconds(), when the next message may be logged
+         mutable std::atomic<uint64_t> _suppressed{0};
+      };
+
+
+      /// A call site with the counters of its rate limit
+      template <typename Limit>
+      struct LimitedCallSite : CallSite, Limit {
+         constexpr LimitedCallSite(std::string_view path, std::string_view function_name, int line_number)
+            : CallSite(path, function_name, line_number), Limit() {}
+      };
+   } // internal
+} // g3
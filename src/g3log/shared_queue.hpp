@@ -17,6 +17,7 @@
 #pragma once
 
 #include <queue>
+#include <chrono>
 #include <mutex>
 #include <exception>
 #include <condition_variable>
@@ -84,6 +85,18 @@ public:
       queue_.pop();
    }
 
+   /// As wait_and_pop, but gives up at the deadline. Returns true if an item was retrieved
+   template<typename Clock, typename Duration>
+   bool wait_and_pop_until(T& popped_item, const std::chrono::time_point<Clock, Duration>& deadline) {
+      std::unique_lock<std::mutex> lock(m_);
+      if (!data_cond_.wait_until(lock, deadline, [this] { return !queue_.empty(); })) {
+         return false;
+      }
+      popped_item = std::move(queue_.front());
+      queue_.pop();
+      return true;
+   }
+
    bool empty() const {
       std::lock_guard<std::mutex> lock(m_);
       return queue_.empty();
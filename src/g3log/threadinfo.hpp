@@ -0,0 +1,33 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace g3 {
+   /** Names the calling thread. The name is shown in the log entries made with
+    * LogMessage::FullLogDetailsToString and, where the platform supports it, also given to
+    * the operating system (pthread_setname_np) so that debuggers and top show it.
+    * Linux shows at most 15 characters there, the log entries show all of it */
+   void setThreadName(std::string_view name);
+
+   /// the name given to the calling thread with setThreadName, or empty
+   std::string_view threadName();
+
+   namespace internal {
+      /// What a LogMessage records of the thread that made it, worked out once per thread
+      struct ThreadInfo {
+         uint64_t id;           // the operating system's thread id: gettid() on Linux
+         std::string_view name; // see g3::setThreadName. The text is never freed
+      };
+
+      const ThreadInfo& currentThreadInfo();
+   } // internal
+} // g3
@@ -86,28 +86,14 @@ namespace g3 {
    * modify this to use std::strftime instead */
    std::string localtime_formatted(const system_time_point& ts, const std::string& time_format) ;
 
-   inline system_time_point to_system_time(const high_resolution_time_point& ts)
-   {
-	   // On some (windows) systems, the system_clock does not provide the highest possible time
-	   // resolution. Thus g3log uses high_resolution_clock for message time stamps. However,
-	   // unlike system_clock, high_resolution_clock cannot be converted to a time and date as
-	   // it usually measures reflects the time since power-up. 
-	   // Thus, hrs_now and sys_now are recorded once when the program starts to be able to convert
-	   // timestamps to time and date using to_system_time(). The precision of the absolute time is
-	   // of course that of system_clock() with some error added due to the non-simultaneous initialization
-	   // of the two static variables but relative times within one log will be as precise as 
-	   // high_resolution_clock.
-	   using namespace std::chrono;
-	   // static time_point now() noexcept;
-	   static const auto hrs_now = high_resolution_clock::now();
-	   static const auto sys_now = system_clock::now();
-	   // template <class ToDuration, class Clock, class Duration>
-	   // time_point<Clock, ToDuration> time_point_cast(const time_point<Clock, Duration>&tp);
-	   //
-	   // The value of tp converted into an object of type time_point<Clock,ToDuration>.
-	   // time_point<Clock, ToDuration> is a time_point with the same Clock type as tp.
-       return time_point_cast<system_clock::duration>(sys_now + (ts - hrs_now));
-   }
+   /** On some (windows) systems, the system_clock does not provide the highest possible time
+   * resolution. Thus g3log uses high_resolution_clock for message time stamps. However,
+   * unlike system_clock, high_resolution_clock cannot always be converted to a time and date as
+   * it might measure the time since power-up.
+   * Where they are different clocks the offset between them is measured again at regular
+   * intervals (see g3log/clock.hpp), so that converted time stamps do not drift from the wall
+   * clock in a long running process. Where they are the same clock nothing is converted */
+   system_time_point to_system_time(const high_resolution_time_point& ts);
 }
 
 
@@ -0,0 +1,88 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#pragma once
+
+#include "g3log/attributes.hpp"
+#include "g3log/callsite.hpp"
+#include "g3log/generated_definitions.hpp"
+#include "g3log/loglevels.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Per file log levels, with G3_LOG_VMODULE (USE_G3_VMODULE in Options.cmake)
+//
+// The levels of g3::log_levels are the same for the whole process. Module rules give the files
+// that match a pattern a minimum level of their own, e.g. DEBUG for one subsystem only:
+//    g3::setVModule("net/*=DEBUG,storage/compaction.cpp=INFO");
+//
+// A rule is 'pattern=level', rules are separated by commas. The first rule that matches a
+// file is used. In a LOG call of that file a level is logged if it is at or above the rule's
+// level, whether the level is enabled in g3::log_levels or not. The LOG calls of files that
+// match no rule are decided by g3::logLevel(level) as before. CHECK calls are not affected.
+// A g3::ScopedThreadLevel overrides the rules on its thread.
+//
+// The pattern is matched against the end of the file path, from the start of a directory or
+// file name: "net/*" matches "/src/net/socket.cpp", but not "/src/subnet/socket.cpp".
+// '*' matches any characters, '/' included, '?' matches one character. '\' in a path is
+// matched as '/'. The level is DEBUG, INFO, WARNING or FATAL, a level's text such as "DBG",
+// or a number. With G3_DYNAMIC_LOGGING the texts of added levels are known as well.
+//
+// The patterns are not matched in the LOG calls. Each call site caches the value of the rule
+// that matches its file, together with the rules' generation, a counter that is increased when
+// the rules are set. The call site only matches the patterns again when the generation has
+// changed: a LOG call costs one more relaxed load and compare than without module rules.
+namespace g3 {
+#if defined(G3_LOG_VMODULE)
+   /// Replaces the module rules, "" removes them. Safe at any time, also while other threads log.
+   /// @return false if the rules could not be parsed, the rules in use are then kept and 'error'
+   /// (if given) tells what was wrong
+   bool setVModule(const std::string& rules, std::string* error = nullptr);
+
+   /// @return the module rules in use, as given to setVModule
+   std::string vModule();
+#endif
+
+   namespace internal {
+#if defined(G3_LOG_VMODULE)
+      /// Increased each time the rules are set
+      extern std::atomic<uint32_t> g_vmodule_generation;
+
+      /// Matches the call site's file against the rules and caches the outcome in the call
+      /// site, see CallSite::module_rule. @return the new cached word
+      uint64_t refreshModuleRule(const CallSite& site);
+#endif
+
+      /// Should a LOG call at 'site' with 'level' be logged. A ScopedThreadLevel of the calling
+      /// thread decides first, then the module rule of the call site, if there is one. Else
+      /// g3::logLevel does
+      inline bool logEnabled(const CallSite& site, const LEVELS& level) {
+#if defined(G3_LOG_VMODULE)
+#ifdef G3_DYNAMIC_LOGGING
+         if (G3_UNLIKELY(kNoThreadLevel != t_thread_level)) {
+            return level.value >= t_thread_level;
+         }
+#endif
+         uint64_t rule = site.module_rule.load(std::memory_order_relaxed);
+         if (G3_UNLIKELY(static_cast<uint32_t>(rule >> 32) != g_vmodule_generation.load(std::memory_order_relaxed))) {
+            rule = refreshModuleRule(site);
+         }
+         const int32_t minimum = static_cast<int32_t>(static_cast<uint32_t>(rule));
+         if (G3_LIKELY(kNoModuleRule == minimum)) {
+            return logLevel(level);
+         }
+         return level.value >= minimum;
+#else
+         (void)site;
+         return logLevel(level);
+#endif
+      }
+   } // internal
+} // g3
@@ -0,0 +1,150 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/hexdump.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define G3_HEXDUMP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+   const char kHexDigits[] = "0123456789abcdef";
+   const size_t kBytesPerLine = g3::internal::kHexDumpBytesPerLine;
+   const size_t kMaxOffsetDigits = 16;
+   const size_t kHexColumns = kBytesPerLine * 3 + 1; // "xx " per byte, one more space in the middle
+
+
+   char* writeOffset(char* out, size_t offset) {
+      size_t digits = 8;
+      while (digits < kMaxOffsetDigits && (offset >> (digits * 4)) != 0) {
+         ++digits;
+      }
+      for (size_t index = digits; index > 0; --index) {
+         out[index - 1] = kHexDigits[offset & 0x0f];
+         offset >>= 4;
+      }
+      return out + digits;
+   }
+
+
+   // the position of byte 'index' in the hex columns
+   size_t hexColumn(size_t index) {
+      return index * 3 + ((index < kBytesPerLine / 2) ? 0 : 1);
+   }
+
+
+   bool isPrintable(unsigned char c) {
+      return c >= 0x20 && c < 0x7f;
+   }
+
+
+   // a line of 1 to 16 bytes, byte by byte
+   char* writeLine(char* out, const unsigned char* data, size_t count) {
+      std::memset(out, ' ', kHexColumns);
+      for (size_t index = 0; index < count; ++index) {
+         char* hex = out + hexColumn(index);
+         hex[0] = kHexDigits[data[index] >> 4];
+         hex[1] = kHexDigits[data[index] & 0x0f];
+      }
+      out += kHexColumns;
+      *out++ = ' ';
+      *out++ = '|';
+      for (size_t index = 0; index < count; ++index) {
+         *out++ = isPrintable(data[index]) ? static_cast<char>(data[index]) : '.';
+      }
+      *out++ = '|';
+      return out;
+   }
+
+
+#if defined(G3_HEXDUMP_SSE2)
+   // a full line of 16 bytes: all the digits of the line and the ascii column are made with a
+   // few SSE2 instructions, the digits are then put in their columns two by two
+   char* writeFullLine(char* out, const unsigned char* data) {
+      const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+      const __m128i low_nibble = _mm_set1_epi8(0x0f);
+      const auto toDigits = [](__m128i nibbles) {
+         // '0' + nibble, and 'a' - '0' - 10 more for the nibbles above 9
+         const __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+         return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                             _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+      };
+      const __m128i high = toDigits(_mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble));
+      const __m128i low = toDigits(_mm_and_si128(bytes, low_nibble));
+
+      char digits[2 * kBytesPerLine];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(digits), _mm_unpacklo_epi8(high, low));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(digits + kBytesPerLine), _mm_unpackhi_epi8(high, low));
+      std::memset(out, ' ', kHexColumns);
+      for (size_t index = 0; index < kBytesPerLine; ++index) {
+         std::memcpy(out + hexColumn(index), digits + 2 * index, 2);
+      }
+      out += kHexColumns;
+      *out++ = ' ';
+      *out++ = '|';
+
+      // bytes from 0x80 are negative as signed chars, so they are not above 0x1f
+      const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1f)),
+                                              _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7f)));
+      const __m128i ascii = _mm_or_si128(_mm_and_si128(printable, bytes),
+                                         _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), ascii);
+      out += kBytesPerLine;
+      *out++ = '|';
+      return out;
+   }
+#else
+   char* writeFullLine(char* out, const unsigned char* data) {
+      return writeLine(out, data, kBytesPerLine);
+   }
+#endif
+} // anonymous
+
+
+
+namespace g3 {
+   std::ostream& operator<<(std::ostream& out, const HexDump& dump) {
+      std::string text(internal::hexDumpLength(dump.size), '\0');
+      char* end = internal::writeHexDumpHeader(&text[0], dump.size, dump.total);
+      end = internal::writeHexDumpLines(end, dump.data, dump.size, 0);
+      return out.write(text.data(), end - text.data());
+   }
+
+
+   namespace internal {
+      char* writeHexDumpHeader(char* out, size_t size, size_t total) {
+         char* end = out + kHexDumpMaxHeaderLength;
+         *out++ = '[';
+         out = std::to_chars(out, end, size).ptr;
+         if (total != size) {
+            std::memcpy(out, " of ", 4);
+            out = std::to_chars(out + 4, end, total).ptr;
+         }
+         std::memcpy(out, " bytes]", 7);
+         return out + 7;
+      }
+
+
+      char* writeHexDumpLines(char* out, const unsigned char* data, size_t size, size_t offset) {
+         for (size_t done = 0; done < size; done += kBytesPerLine) {
+            *out++ = '\n';
+            out = writeOffset(out, offset + done);
+            *out++ = ' ';
+            *out++ = ' ';
+            const size_t count = size - done;
+            out = (count >= kBytesPerLine) ? writeFullLine(out, data + done) : writeLine(out, data + done, count);
+         }
+         return out;
+      }
+   } // internal
+} // g3
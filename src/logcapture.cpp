@@ -9,10 +9,14 @@
 #include "g3log/logcapture.hpp"
 #include "g3log/g3log.hpp"
 #include "g3log/crashhandler.hpp"
+#include "g3log/logmessagepool.hpp"
 
-#ifdef G3_DYNAMIC_MAX_MESSAGE_SIZE
-#include <vector>
-#endif /* G3_DYNAMIC_MAX_MESSAGE_SIZE */
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef G3_LOG_TZ_VSNPRINTF
+#include "g3log/format_string.hpp"
+#endif
 
 // For Windows we need force a thread_local install per thread of three
 // signals that must have a signal handler installed per thread-basis
@@ -33,16 +37,76 @@ void g3::only_change_at_initialization::setMaxMessageSize(size_t max_size) {
  }
 #endif /* G3_DYNAMIC_MAX_MESSAGE_SIZE */
 
+namespace {
+   // the LOGF formatting engine, chosen with G3_LOGF_BACKEND in Options.cmake. Both have the
+   // C99 vsnprintf contract: never more than 'room' bytes are written, the '\0' included, and
+   // the length of the whole text is returned
+   inline int formatLogf(char* destination, size_t room, const char* format, va_list arguments) {
+#ifdef G3_LOG_TZ_VSNPRINTF
+      return tz_vsnprintf(destination, room, format, arguments);
+#else
+      return vsnprintf(destination, room, format, arguments);
+#endif
+   }
+} // anonymous
+
 /** logCapture is a simple struct for capturing log/fatal entries. At destruction the
 * captured message is forwarded to background worker.
-* As a safety precaution: No memory allocated here will be moved into the background
-* worker in case of dynamic loaded library reasons instead the arguments are copied
-* inside of g3log.cpp::saveMessage*/
+* The LogMessage is built here, directly from the captured stream, so the text is only
+* copied once. For the LOG/CHECK macros the message refers to the strings of the static
+* g3::CallSite, unless the call site is in a library that could be unloaded.
+* Without a call site the strings are copied as a safety precaution for dynamically
+* loaded libraries, unless G3_LOG_INPLACE_CAPTURE is defined*/
 LogCapture::~LogCapture() noexcept (false) {
    using namespace g3::internal;
+   // the stream goes back to the thread's cache also if saveMessage throws
+   struct StreamRelease {
+      g3::LogStream* stream;
+      ~StreamRelease() { releaseLogStream(stream); }
+   } release {_stream};
+
    SIGNAL_HANDLER_VERIFY();
-   saveMessage(_stream.str().c_str(), _file, _line, _function, _level, 
-               _expression, _fatal_signal, _stack_trace.c_str());
+   if (nullptr != _lazy && (nullptr == _site || !_site->referable() || g3::internal::wasFatal(_level))) {
+      // the callable's code could be unloaded with its library before the LogWorker gets to it,
+      // and a fatal message is not formatted later. See g3log/loglazy.hpp
+      *_stream << _lazy->text();
+      _lazy.reset();
+   }
+   if (_suppressed > 0) {
+      *_stream << " (suppressed " << _suppressed << " since last)";
+   }
+#ifdef G3_LOG_INPLACE_CAPTURE
+   const auto details = g3::LogMessage::Details::Reference;
+#else
+   const auto details = g3::LogMessage::Details::Copy;
+#endif
+   const bool deferred = _stream->deferred();
+   const auto text = deferred ? std::string_view() : std::string_view(_stream->c_str(), _stream->size());
+#ifdef G3_LOG_MESSAGE_POOL
+   // a recycled message, the LogWorker gives it back to the pool. See LogWorkerImpl::bgSave
+   g3::LogMessagePtr message {acquireLogMessage()};
+   if (nullptr != _site) {
+      message.get()->reuse(*_site, _level, _expression, text);
+   } else {
+      message.get()->reuse(_file, _line, _function, _level, _expression, text, details);
+   }
+#else
+   g3::LogMessagePtr message {(nullptr != _site)
+                              ? std::make_unique<g3::LogMessage>(*_site, _level, _expression, text)
+                              : std::make_unique<g3::LogMessage>(_file, _line, _function, _level, _expression,
+                                                                 text, details)};
+#endif
+   if (deferred) {
+      // formatted later, by the LogWorker. See LogWorkerImpl::bgSave
+      message.get()->_arguments.assign(_stream->arguments());
+   }
+   if (!_stream->fields().empty()) {
+      message.get()->_fields.assign(_stream->fields());
+   }
+   if (nullptr != _lazy) {
+      message.get()->_lazy = std::move(_lazy);
+   }
+   saveMessage(message, _fatal_signal, _stack_trace.c_str());
 }
 
 
@@ -51,6 +115,12 @@ LogCapture::LogCapture(const LEVELS &level, g3::SignalType fatal_signal, const c
 LogCapture("", 0, "", level, "", fatal_signal, dump) {
 } // using list-initialization to realize constructor calling constructor
 
+LogCapture::LogCapture(const g3::CallSite& site, const LEVELS& level, const char* expression,
+                       g3::SignalType fatal_signal, const char* dump)
+   : LogCapture(site.file_path.data(), site.line, site.function.data(), level, expression, fatal_signal, dump) {
+   _site = &site;
+}
+
 /**
  * @file, line, function are given in g3log.hpp from macros
  * @level INFO/DEBUG/WARNING/FATAL
@@ -59,7 +129,13 @@ LogCapture("", 0, "", level, "", fatal_signal, dump) {
  */
 LogCapture::LogCapture(const char* file, const int line, const char* function, const LEVELS &level,
                        const char* expression, g3::SignalType fatal_signal, const char* dump)
-   : _file(file), _line(line), _function(function), _level(level), _expression(expression), _fatal_signal(fatal_signal) {
+   : _stream(g3::internal::acquireLogStream()), _file(file), _line(line), _function(function), _level(level)
+   , _expression(expression), _fatal_signal(fatal_signal) {
+
+#ifdef G3_LOG_DEFERRED_FORMATTING
+   // fatal messages are formatted right away: the process is about to go down
+   _stream->setDeferred(!g3::internal::wasFatal(level));
+#endif
 
    if (g3::internal::wasFatal(level)) {
       _stack_trace = std::string{"\n*******\tSTACKDUMP *******\n"};
@@ -71,75 +147,51 @@ LogCapture::LogCapture(const char* file, const int line, const char* function, c
 /**
 * capturef, used for "printf" like API in CHECKF, LOGF, LOGF_IF
 * See also for the attribute formatting ref:  http://www.codemaestro.com/reviews/18
+*
+* The text is formatted straight into the thread's LogStream buffer, which keeps its capacity
+* between log calls. Only if the free space there is too small is the text formatted a second
+* time, after the buffer has grown to the size vsnprintf reported. Nothing is truncated, unless
+* a limit is set with G3_DYNAMIC_MAX_MESSAGE_SIZE
 */
 void LogCapture::capturef(const char* printf_like_message, ...) {
-   static const std::string kTruncatedWarningText = "[...truncated...]";
-#ifdef G3_DYNAMIC_MAX_MESSAGE_SIZE
-   std::vector<char> finished_message_backing(MaxMessageSize);
-   char* finished_message = finished_message_backing.data();
-   auto finished_message_len = MaxMessageSize;
-#else
-   static const int kMaxMessageSize = 2048;
-   char finished_message[kMaxMessageSize];
-#if ((defined(WIN32) || defined(_WIN32) || defined(__WIN32__)) && !defined(__GNUC__))
-   auto finished_message_len = _countof(finished_message);
-   /* 
-    * #ifndef _countof
-    * #define _countof __crt_countof
-    * #endif 
-    * 
-    * #ifdef __cplusplus
-    * extern "C++"
-    * {
-    *     template <typename _CountofType, size_t _SizeOfArray>
-    *     char (* __countof_helper(_UNALIGNED _CountofType (&_Array)[_SizeOfArray]) )[_SizeOfArray];
-    *     // __countof_helper(_UNALIGNED _CountofType (&_Array)[_SizeOfArray]) retuns 
-    *     // char(*)[_SizeOfArray]
-    * 
-    *     #define __crt_countof(_Array) (sizeof(*__countof_helper(_Array)) + 0)
-    * }
-    * #else
-    * #define __crt_countof(_Array) (sizeof(_Array) / sizeof(_Array[0]))
-    * #endif
-    */
-#else
-   int finished_message_len = sizeof(finished_message);
-#endif
-#endif /* G3_DYNAMIC_MAX_MESSAGE_SIZE */
+   const size_t kMinimumRoom = 256;
+   auto& out = stream().textBuffer();
+   char* destination = out.reserve(kMinimumRoom);
+   size_t room = out.available(); // all of the capacity, the buffer is usually larger than this
 
    va_list arglist;
    va_start(arglist, printf_like_message);
+   va_list retry;
+   va_copy(retry, arglist);
 
-#if ((defined(WIN32) || defined(_WIN32) || defined(__WIN32__)) && !defined(__GNUC__))
-   const int nbrcharacters = vsnprintf_s(finished_message, finished_message_len, _TRUNCATE, printf_like_message, arglist);
-#else
-   const int nbrcharacters = vsnprintf(finished_message, finished_message_len, printf_like_message, arglist);
-#endif
+   // vsnprintf never writes more than 'room' bytes, the terminating '\0' included. It
+   // returns the number of characters the whole text needs, without the '\0', or a
+   // negative number for an encoding error. Visual Studio 2015 and later are conforming
+   int nbrcharacters = formatLogf(destination, room, printf_like_message, arglist);
    va_end(arglist);
+   if (nbrcharacters >= 0 && static_cast<size_t>(nbrcharacters) >= room) {
+      room = static_cast<size_t>(nbrcharacters) + 1;
+      destination = out.reserve(room);
+      nbrcharacters = formatLogf(destination, room, printf_like_message, retry);
+   }
+   va_end(retry);
 
-   // Upon successful return, these vsnprintf return the number of 
-   // characters printed( <= finished_message_len - 1 and excluding the '\0' 
-   // used to end output to strings).
-   //
-   // vsnprintf do not write more than finished_message_len bytes(including the
-   // terminating null byte('\0')). If the output was truncated due to this 
-   // limit, then the return value is the number of characters(excluding
-   // the terminating null byte) which would have been written to the final
-   // string if enough space had been available. Thus, a return value of 
-   // finished_message_len or more means that the output was truncated.
-   // 
-   // nbrcharacters is the number of characters that would have been written 
-   // if finished_message_len had been sufficiently large, not counting the 
-   // terminating null character.
-   // If an encoding error occurs, a negative number is returned.
-   // Notice that only when this returned value is non-negative and less than 
-   // finished_message_len, the string has been completely written (without truncating).
    if (nbrcharacters < 0) {
       stream() << "\n\tERROR LOG MSG NOTIFICATION: Failure to successfully parse the message";
       stream() << '"' << printf_like_message << '"' << std::endl;
-   } else if (nbrcharacters >= finished_message_len) {
-      stream() << finished_message << kTruncatedWarningText;
-   } else { // nbrcharacters <= finished_message_len - 1
-      stream() << finished_message;
+      return;
    }
+
+   const size_t length = static_cast<size_t>(nbrcharacters);
+#ifdef G3_DYNAMIC_MAX_MESSAGE_SIZE
+   // the limit counts the terminating '\0', as it did for the fixed size buffer
+   const size_t limit = (MaxMessageSize > 0) ? static_cast<size_t>(MaxMessageSize) - 1 : 0;
+   if (length > limit) {
+      static const std::string kTruncatedWarningText = "[...truncated...]";
+      out.commit(limit);
+      out.append(kTruncatedWarningText.data(), kTruncatedWarningText.size());
+      return;
+   }
+#endif /* G3_DYNAMIC_MAX_MESSAGE_SIZE */
+   out.commit(length);
 }
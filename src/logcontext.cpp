@@ -0,0 +1,71 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/logcontext.hpp"
+
+namespace {
+   // The context of the thread's innermost ScopedContext. A plain pointer, a thread_local
+   // without destructor: it is still usable by LOG calls in other thread_local destructors
+   thread_local const g3::LogContextPtr* t_context = nullptr;
+} // anonymous
+
+
+namespace g3 {
+   std::vector<ContextField> LogContext::fields() const {
+      std::vector<ContextField> all;
+      if (_outer) {
+         all = _outer->fields();
+      }
+      all.insert(all.end(), _fields.begin(), _fields.end());
+      return all;
+   }
+
+
+   std::string LogContext::toString() const {
+      std::string out;
+      appendTo(out);
+      return out;
+   }
+
+
+   void LogContext::appendTo(std::string& out) const {
+      if (_outer) {
+         _outer->appendTo(out);
+      }
+      for (const auto& field : _fields) {
+         if (!out.empty()) {
+            out.append(" ");
+         }
+         out.append(field.key).append("=").append(field.value);
+      }
+   }
+
+
+   LogContextPtr currentContext() {
+      return (nullptr == t_context) ? nullptr : *t_context;
+   }
+
+
+   ScopedContext::ScopedContext(std::initializer_list<ContextField> fields)
+      : _context(std::make_shared<const LogContext>(currentContext(), std::vector<ContextField>(fields)))
+      , _previous(t_context) {
+      t_context = &_context;
+   }
+
+
+   ScopedContext::ScopedContext(LogContextPtr context)
+      : _context(std::move(context))
+      , _previous(t_context) {
+      t_context = &_context;
+   }
+
+
+   ScopedContext::~ScopedContext() {
+      t_context = _previous;
+   }
+} // g3
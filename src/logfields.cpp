@@ -0,0 +1,135 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/logfields.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <sstream>
+
+namespace {
+   template <typename Value>
+   void appendValue(std::string& record, Value value) {
+      record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+   }
+
+   void appendText(std::string& record, std::string_view text) {
+      appendValue(record, static_cast<uint32_t>(text.size()));
+      record.append(text.data(), text.size());
+   }
+} // anonymous
+
+
+namespace g3 {
+   std::string LogField::valueToString() const {
+      char digits[64];
+      switch (type) {
+         case Type::Int: {
+            auto result = std::to_chars(digits, digits + sizeof(digits), integer);
+            return std::string(digits, result.ptr);
+         }
+         case Type::UInt: {
+            auto result = std::to_chars(digits, digits + sizeof(digits), unsigned_integer);
+            return std::string(digits, result.ptr);
+         }
+         case Type::Double: {
+            // as a LOG(...) << value with the default precision would write it
+            std::ostringstream out;
+            out << floating;
+            return out.str();
+         }
+         case Type::Bool:
+            return boolean ? "true" : "false";
+         case Type::String:
+            return std::string(text);
+      }
+      return {};
+   }
+
+
+   // The record is produced by a LogStream in the same process, it is trusted to be complete.
+   // Reading is still bounds checked: a broken record ends the fields, it is never read past
+   void LogFields::const_iterator::next() {
+      _current = _end;
+      if (_read >= _end) {
+         return;
+      }
+      const char* read = _read;
+      auto take = [&](void* value, size_t size) {
+         if (static_cast<size_t>(_end - read) < size) {
+            return false;
+         }
+         std::memcpy(value, read, size);
+         read += size;
+         return true;
+      };
+      auto takeText = [&](std::string_view& text) {
+         uint32_t length = 0;
+         if (!take(&length, sizeof(length)) || static_cast<size_t>(_end - read) < length) {
+            return false;
+         }
+         text = std::string_view(read, length);
+         read += length;
+         return true;
+      };
+
+      LogField field;
+      field.type = static_cast<LogField::Type>(*read++);
+      if (!takeText(field.key)) {
+         _read = _end;
+         return;
+      }
+      bool complete = false;
+      switch (field.type) {
+         case LogField::Type::Int: complete = take(&field.integer, sizeof(field.integer)); break;
+         case LogField::Type::UInt: complete = take(&field.unsigned_integer, sizeof(field.unsigned_integer)); break;
+         case LogField::Type::Double: complete = take(&field.floating, sizeof(field.floating)); break;
+         case LogField::Type::Bool: {
+            char value = 0;
+            complete = take(&value, sizeof(value));
+            field.boolean = (0 != value);
+            break;
+         }
+         case LogField::Type::String: complete = takeText(field.text); break;
+      }
+      if (!complete) {
+         _read = _end;
+         return;
+      }
+      _current = _read;
+      _field = field;
+      _read = read;
+   }
+
+
+   std::string LogFields::toString() const {
+      std::string out;
+      for (const auto& field : *this) {
+         if (!out.empty()) {
+            out.append(" ");
+         }
+         out.append(field.key).append("=").append(field.valueToString());
+      }
+      return out;
+   }
+
+
+   namespace internal {
+      void appendField(std::string& record, const LogField& field) {
+         record.push_back(static_cast<char>(field.type));
+         appendText(record, field.key);
+         switch (field.type) {
+            case LogField::Type::Int: appendValue(record, field.integer); break;
+            case LogField::Type::UInt: appendValue(record, field.unsigned_integer); break;
+            case LogField::Type::Double: appendValue(record, field.floating); break;
+            case LogField::Type::Bool: record.push_back(field.boolean ? 1 : 0); break;
+            case LogField::Type::String: appendText(record, field.text); break;
+         }
+      }
+   } // internal
+} // g3
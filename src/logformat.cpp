@@ -0,0 +1,246 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/logformat.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+namespace {
+   using g3::internal::LogStreamBuf;
+   using g3::internal::FormatSpec;
+
+   // opens a gap of 'count' fill characters at 'position' in what is already written
+   void insertAt(LogStreamBuf& out, size_t position, size_t count, char fill) {
+      const size_t tail = out.size() - position;
+      out.reserve(count); // might move the buffer, so data() is read after this
+      char* base = out.data();
+      std::memmove(base + position + count, base + position, tail);
+      std::memset(base + position, fill, count);
+      out.commit(count);
+   }
+
+   void toUpper(LogStreamBuf& out, size_t start) {
+      char* data = out.data();
+      for (size_t i = start; i < out.size(); ++i) {
+         data[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(data[i])));
+      }
+   }
+
+   void writeSign(LogStreamBuf& out, bool negative, const FormatSpec& spec) {
+      if (negative) {
+         out.append("-", 1);
+      } else if ('+' == spec.sign || ' ' == spec.sign) {
+         out.append(&spec.sign, 1);
+      }
+   }
+
+   // '0' padding goes between the sign/prefix and the digits. An explicit alignment turns it off
+   void zeroPad(LogStreamBuf& out, size_t start, size_t digits_start, const FormatSpec& spec) {
+      const size_t length = out.size() - start;
+      const auto width = static_cast<size_t>(spec.width);
+      if (spec.zero_pad && 0 == spec.align && width > length) {
+         insertAt(out, digits_start, width - length, '0');
+      }
+   }
+
+   void writeInteger(LogStreamBuf& out, bool negative, unsigned long long magnitude, const FormatSpec& spec) {
+      const size_t start = out.size();
+      writeSign(out, negative, spec);
+
+      int base = 10;
+      const char* prefix = "";
+      switch (spec.type) {
+         case 'x': base = 16; prefix = "0x"; break;
+         case 'X': base = 16; prefix = "0X"; break;
+         case 'b': base = 2; prefix = "0b"; break;
+         case 'B': base = 2; prefix = "0B"; break;
+         case 'o': base = 8; prefix = (0 == magnitude) ? "" : "0"; break;
+         default: break;
+      }
+      if (spec.alternate) {
+         out.append(prefix, std::strlen(prefix));
+      }
+
+      const size_t digits_start = out.size();
+      const size_t kMaxDigits = 64; // binary representation of 64 bits
+      char* digits = out.reserve(kMaxDigits);
+      auto result = std::to_chars(digits, digits + kMaxDigits, magnitude, base);
+      out.commit(static_cast<size_t>(result.ptr - digits));
+      if ('X' == spec.type) {
+         toUpper(out, digits_start);
+      }
+
+      zeroPad(out, start, digits_start, spec);
+      g3::internal::formatPadding(out, start, spec, '>');
+   }
+} // anonymous
+
+
+
+namespace g3 {
+   namespace internal {
+
+      // the format string is already verified: every brace in the literal text is doubled
+      void formatLiteral(LogStreamBuf& out, const char* begin, const char* end) {
+         while (begin < end) {
+            const char* brace = begin;
+            while (brace < end && *brace != '{' && *brace != '}') {
+               ++brace;
+            }
+            if (brace == end) {
+               out.append(begin, static_cast<size_t>(end - begin));
+               return;
+            }
+            out.append(begin, static_cast<size_t>(brace + 1 - begin));
+            begin = brace + 2;
+         }
+      }
+
+
+      void formatPadding(LogStreamBuf& out, size_t start, const FormatSpec& spec, char default_align) {
+         const size_t length = out.size() - start;
+         const auto width = static_cast<size_t>(spec.width);
+         if (width <= length) {
+            return;
+         }
+         const size_t fill = width - length;
+         const char align = (0 == spec.align) ? default_align : spec.align;
+         const size_t before = ('>' == align) ? fill : ('^' == align) ? fill / 2 : 0;
+         const size_t after = fill - before;
+         if (before > 0) {
+            insertAt(out, start, before, spec.fill);
+         }
+         if (after > 0) {
+            std::memset(out.reserve(after), spec.fill, after);
+            out.commit(after);
+         }
+      }
+
+
+      void formatBool(LogStreamBuf& out, bool value, const FormatSpec& spec) {
+         formatString(out, value ? "true" : "false", spec);
+      }
+
+
+      void formatChar(LogStreamBuf& out, char value, const FormatSpec& spec) {
+         if (0 == spec.type || 'c' == spec.type) {
+            const size_t start = out.size();
+            out.append(&value, 1);
+            formatPadding(out, start, spec, '<');
+            return;
+         }
+         // as a number, like std::format, the char is seen as unsigned
+         formatUnsigned(out, static_cast<unsigned char>(value), spec);
+      }
+
+
+      void formatSigned(LogStreamBuf& out, long long value, const FormatSpec& spec) {
+         if ('c' == spec.type) {
+            formatChar(out, static_cast<char>(value), FormatSpec{spec.fill, spec.align, 0, false, false, spec.width, -1, 'c'});
+            return;
+         }
+         const bool negative = value < 0;
+         // negating the most negative value overflows, the unsigned arithmetic does not
+         const unsigned long long magnitude = negative ? 0ULL - static_cast<unsigned long long>(value)
+                                                       : static_cast<unsigned long long>(value);
+         writeInteger(out, negative, magnitude, spec);
+      }
+
+
+      void formatUnsigned(LogStreamBuf& out, unsigned long long value, const FormatSpec& spec) {
+         if ('c' == spec.type) {
+            formatChar(out, static_cast<char>(value), FormatSpec{spec.fill, spec.align, 0, false, false, spec.width, -1, 'c'});
+            return;
+         }
+         writeInteger(out, false, value, spec);
+      }
+
+
+      void formatFloating(LogStreamBuf& out, double value, const FormatSpec& spec) {
+         const size_t start = out.size();
+         writeSign(out, std::signbit(value), spec);
+         const double magnitude = std::fabs(value);
+         const size_t digits_start = out.size();
+         const int precision = spec.precision;
+
+         // fixed notation of the largest double is 309 digits, before the decimals
+         const size_t capacity = 330 + static_cast<size_t>((precision > 0) ? precision : 0);
+         char* digits = out.reserve(capacity);
+         char* const digits_end = digits + capacity;
+#if defined(__cpp_lib_to_chars)
+         std::to_chars_result result {digits, std::errc()};
+         switch (spec.type) {
+            case 'f': case 'F':
+               result = std::to_chars(digits, digits_end, magnitude, std::chars_format::fixed, (precision < 0) ? 6 : precision);
+               break;
+            case 'e': case 'E':
+               result = std::to_chars(digits, digits_end, magnitude, std::chars_format::scientific, (precision < 0) ? 6 : precision);
+               break;
+            case 'g': case 'G':
+               result = std::to_chars(digits, digits_end, magnitude, std::chars_format::general, (precision < 0) ? 6 : precision);
+               break;
+            case 'a': case 'A':
+               result = (precision < 0) ? std::to_chars(digits, digits_end, magnitude, std::chars_format::hex)
+                                        : std::to_chars(digits, digits_end, magnitude, std::chars_format::hex, precision);
+               break;
+            default: // the shortest text that reads back to the same value, as std::format does
+               result = (precision < 0) ? std::to_chars(digits, digits_end, magnitude)
+                                        : std::to_chars(digits, digits_end, magnitude, std::chars_format::general, precision);
+               break;
+         }
+         out.commit((std::errc() == result.ec) ? static_cast<size_t>(result.ptr - digits) : 0);
+#else
+         char conversion = 'g';
+         int digits_wanted = (precision < 0) ? 6 : precision;
+         switch (spec.type) {
+            case 'f': case 'F': conversion = 'f'; break;
+            case 'e': case 'E': conversion = 'e'; break;
+            case 'a': case 'A': conversion = 'a'; break;
+            case 'g': case 'G': break;
+            default: digits_wanted = (precision < 0) ? 17 : precision; break;
+         }
+         const char printf_format[] = {'%', '.', '*', conversion, '\0'};
+         const int written = std::snprintf(digits, capacity, printf_format, digits_wanted, magnitude);
+         out.commit((written > 0 && static_cast<size_t>(written) < capacity) ? static_cast<size_t>(written) : 0);
+#endif
+         if ('F' == spec.type || 'E' == spec.type || 'G' == spec.type || 'A' == spec.type) {
+            toUpper(out, digits_start);
+         }
+
+         if (std::isfinite(value)) {
+            zeroPad(out, start, digits_start, spec);
+         }
+         formatPadding(out, start, spec, '>');
+      }
+
+
+      void formatString(LogStreamBuf& out, std::string_view value, const FormatSpec& spec) {
+         const size_t start = out.size();
+         if (spec.precision >= 0 && value.size() > static_cast<size_t>(spec.precision)) {
+            value = value.substr(0, static_cast<size_t>(spec.precision));
+         }
+         out.append(value.data(), value.size());
+         formatPadding(out, start, spec, '<');
+      }
+
+
+      void formatPointer(LogStreamBuf& out, uintptr_t value, const FormatSpec& spec) {
+         const size_t start = out.size();
+         out.append("0x", 2);
+         const size_t kMaxDigits = 2 * sizeof(uintptr_t);
+         char* digits = out.reserve(kMaxDigits);
+         auto result = std::to_chars(digits, digits + kMaxDigits, value, 16);
+         out.commit(static_cast<size_t>(result.ptr - digits));
+         formatPadding(out, start, spec, '>');
+      }
+   } // internal
+} // g3
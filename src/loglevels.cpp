@@ -10,6 +10,7 @@
 #include <cassert>
 
 #include <iostream>
+#include <mutex>
 
 namespace g3 {
    namespace internal {
@@ -18,25 +19,74 @@ namespace g3 {
       }
 
 #ifdef G3_DYNAMIC_LOGGING
-      const std::map<int, LoggingLevel> g_log_level_defaults = {
-         // loglevels.hpp  g3::LoggingLevel::LoggingLevel
-         // LoggingLevel(const LEVELS& lvl): status(true), level(lvl) {};
-	     {G3LOG_DEBUG.value, {G3LOG_DEBUG}}, // std::pair
-         {INFO.value, {INFO}},
-         {WARNING.value, {WARNING}},
-         {FATAL.value, {FATAL}}
-      };
-
-      std::map<int, g3::LoggingLevel> g_log_levels = g_log_level_defaults;
+      LevelTable g_level_table {std::make_index_sequence<kLevelTableSize>{}};
 #endif
    } // internal
 
 #ifdef G3_DYNAMIC_LOGGING
+   namespace {
+      using LevelMap = std::map<int, LEVELS>;
+
+      LevelMap defaultLevels() {
+         return {{G3LOG_DEBUG.value, G3LOG_DEBUG}, {INFO.value, INFO}, {WARNING.value, WARNING}, {FATAL.value, FATAL}};
+      }
+
+      /// The names of all levels, and the status of the levels outside of the level table.
+      /// Every change of a level is made with the mutex held
+      struct Levels {
+         std::mutex mutex;
+         LevelMap names = defaultLevels();
+         std::map<int, bool> outside_table;
+      };
+
+      // Never destroyed: levels can be checked and changed until the very end
+      Levels& levels() {
+         static Levels* instance = new Levels;
+         return *instance;
+      }
+
+      bool inTable(int value) {
+         return static_cast<unsigned>(value) < static_cast<unsigned>(internal::kLevelTableSize);
+      }
+
+      // with the mutex held
+      void storeStatus(Levels& all, int value, bool enabled) {
+         if (inTable(value)) {
+            const uint8_t status = enabled ? internal::kLevelEnabled : internal::kLevelDisabled;
+            internal::g_level_table.status[value].store(status, std::memory_order_relaxed);
+         } else {
+            all.outside_table[value] = enabled;
+         }
+      }
+
+      // with the mutex held
+      bool loadStatus(const Levels& all, int value) {
+         if (inTable(value)) {
+            return internal::kLevelEnabled == internal::g_level_table.status[value].load(std::memory_order_relaxed);
+         }
+         const auto found = all.outside_table.find(value);
+         return all.outside_table.end() != found && found->second;
+      }
+   } // anonymous
+
+
+   namespace internal {
+      bool logLevelOutsideTable(int value) {
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         return loadStatus(all, value);
+      }
+   } // internal
+
+
    namespace only_change_at_initialization {
 
       void addLogLevel(LEVELS lvl, bool enabled) {
-         int value = lvl.value;
-         internal::g_log_levels[value] = {lvl, enabled};
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         const int value = lvl.value;
+         all.names.insert_or_assign(value, lvl);
+         storeStatus(all, value, enabled);
       }
 
 
@@ -45,19 +95,13 @@ namespace g3 {
       }
 
       void reset() {
-         // Copy assignment operator. Replaces the contents of g_log_levels 
-         // with a copy of the contents of g_log_level_defaults.
-         // If 
-         // std::allocator_traits<allocator_type>::propagate_on_container_copy_assignment::value 
-         // is true, the allocator of g_log_levels is replaced by a copy of that of
-         // g_log_level_defaults. If the allocator of g_log_levels after assignment would compare 
-         // unequal to its old value, the old allocator is used to deallocate 
-         // the memory, then the new allocator is used to allocate it before 
-         // copying the elements. Otherwise, the memory owned by g_log_levels may be 
-         // reused when possible. In any case, the elements originally belong 
-         // to g_log_levels may be either destroyed or replaced by element-wise copy-assignment
-         // with g_log_level_defaults.
-         g3::internal::g_log_levels = g3::internal::g_log_level_defaults;
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         for (int value = 0; value < internal::kLevelTableSize; ++value) {
+            internal::g_level_table.status[value].store(internal::defaultLevelStatus(value), std::memory_order_relaxed);
+         }
+         all.outside_table.clear();
+         all.names = defaultLevels();
       }
    } // only_change_at_initialization
 
@@ -65,27 +109,24 @@ namespace g3 {
    namespace log_levels {
 
       void setHighest(LEVELS enabledFrom) {
-         auto it = internal::g_log_levels.find(enabledFrom.value);
-         if (it != internal::g_log_levels.end()) {
-            for (auto& v : internal::g_log_levels) {
-               if (v.first < enabledFrom.value) {
-                  disable(v.second.level);
-               } else {
-                  enable(v.second.level);
-               }
-            }
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         if (all.names.end() == all.names.find(enabledFrom.value)) {
+            return;
+         }
+         for (auto& v : all.names) {
+            storeStatus(all, v.first, v.first >= enabledFrom.value);
          }
       }
 
 
       void set(LEVELS level, bool enabled) {
-         auto it = internal::g_log_levels.find(level.value);
-         if (it != internal::g_log_levels.end()) {
-            // loglevels.hpp  g3::LoggingLevel::LoggingLevel
-            // LoggingLevel(const LEVELS& lvl, bool enabled);
-            // loglevels.hpp  g3::LoggingLevel::operator=
-            // LoggingLevel& operator=(const LoggingLevel& other);
-            internal::g_log_levels[level.value] = {level, enabled};
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         auto it = all.names.find(level.value);
+         if (it != all.names.end()) {
+            it->second = level;
+            storeStatus(all, level.value, enabled);
          }
       }
 
@@ -100,19 +141,19 @@ namespace g3 {
 
 
       void disableAll() {
-         for (auto& v : internal::g_log_levels) {
-            // atomicbool.hpp  g3::atomicbool::operator=
-            // atomicbool& operator=(const bool other);
-            v.second.status = false;
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         for (auto& v : all.names) {
+            storeStatus(all, v.first, false);
          }
       }
 
 
       void enableAll() {
-         for (auto& v : internal::g_log_levels) {
-            // atomicbool.hpp  g3::atomicbool::operator=
-            // atomicbool& operator=(const bool other);
-            v.second.status = true;
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         for (auto& v : all.names) {
+            storeStatus(all, v.first, true);
          }
       }
 
@@ -130,46 +171,30 @@ namespace g3 {
       }
 
       std::string to_string() {
-         return to_string(internal::g_log_levels);
+         return to_string(getAll());
       }
 
 
       std::map<int, g3::LoggingLevel> getAll() {
-         return internal::g_log_levels;
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         std::map<int, g3::LoggingLevel> snapshot;
+         for (auto& v : all.names) {
+            snapshot.emplace(v.first, g3::LoggingLevel {v.second, loadStatus(all, v.first)});
+         }
+         return snapshot;
       }
 
       // status : {Absent, Enabled, Disabled};
       status getStatus(LEVELS level) {
-         const auto it = internal::g_log_levels.find(level.value);
-         if (internal::g_log_levels.end() == it) {
+         auto& all = levels();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         if (all.names.end() == all.names.find(level.value)) {
             return status::Absent;
          }
-
-         // std::atomic<T>::load
-         // T load( std::memory_order order = std::memory_order_seq_cst ) const volatile noexcept;
-         // atomicbool.hpp  g3::atomicbool::get
-         // std::atomic<bool>& get();
-         return (it->second.status.get().load() ? status::Enabled : status::Disabled);
+         return (loadStatus(all, level.value) ? status::Enabled : status::Disabled);
       }
    } // log_levels
 
 #endif
-
-   /// Enabled status for the given logging level
-   // If level does not match the key of any element in g_log_levels, the 
-   // function g_log_levels[level] inserts a new LoggingLevel element and 
-   // returns a reference to its mapped value. Notice that this always 
-   // increases the container size by one, even if no mapped value is 
-   // assigned to the element (the new LoggingLevel element is constructed 
-   // using its default constructor: "LoggingLevel(): status(false), level(INFO) {}"
-   // in which case the function logLevel() always returns false).
-   bool logLevel(const LEVELS& log_level) {
-#ifdef G3_DYNAMIC_LOGGING
-      int level = log_level.value;
-      bool status = internal::g_log_levels[level].status.value();
-      return status;
-#else
-      return true;
-#endif
-   }
 } // g3
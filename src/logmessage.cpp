@@ -9,13 +9,48 @@
 #include "g3log/logmessage.hpp"
 #include "g3log/crashhandler.hpp"
 #include "g3log/time.hpp"
+#include "g3log/logstream.hpp"
+#include "g3log/clock.hpp"
 #include <mutex>
+#include <functional>
+#include <charconv>
 
 
 
 
 namespace g3 {
 
+   namespace {
+      bool pointsInto(std::string_view view, const std::string& block) {
+         const std::less_equal<const char*> less_equal; // total order, also for unrelated pointers
+         return !view.empty() && less_equal(block.data(), view.data()) && less_equal(view.data(), block.data() + block.size());
+      }
+
+      // moves a view that pointed into a block at 'old_base' to the same position in 'new_base'
+      void relocate(std::string_view& view, const char* old_base, size_t old_size, const char* new_base) {
+         if (view.data() >= old_base && view.data() + view.size() <= old_base + old_size) {
+            view = std::string_view(new_base + (view.data() - old_base), view.size());
+         }
+      }
+
+      // "{req=42 tenant=acme} " if the message was logged with a g3::ScopedContext
+      void appendContext(std::string& out, const LogMessage& msg) {
+         if (msg._context) {
+            out.append("{").append(msg._context->toString()).append("} ");
+         }
+      }
+
+      // the message text and the g3::kv fields after it: "done latency_us=123"
+      std::string messageWithFields(const LogMessage& msg) {
+         std::string text = msg.message();
+         if (!msg._fields.empty()) {
+            text.append(" ").append(msg.fields().toString());
+         }
+         return text;
+      }
+   } // anonymous
+
+
    std::string LogMessage::splitFileName(const std::string& str) {
       size_t found;
       // Searches the string for the last character that matches any of the 
@@ -52,7 +87,7 @@ namespace g3 {
       auto out = msg._logDetailsToStringFunc(msg);
       static const std::string fatalExitReason = { 
           "EXIT trigger caused by LOG(FATAL) entry: " };
-      out.append("\n    *******    " + fatalExitReason + "\n    " + '"' + msg.message() + '"' + '\n');
+      out.append("\n    *******    " + fatalExitReason + "\n    " + '"' + messageWithFields(msg) + '"' + '\n');
       return out;
    }
 
@@ -62,7 +97,7 @@ namespace g3 {
       static const std::string contractExitReason = {
           "EXIT trigger caused by broken Contract:" };
       out.append("\n    *******    " + contractExitReason + " CHECK(" + msg.expression() + ")\n    "
-                 + '"' + msg. message() + '"' + '\n');
+                 + '"' + messageWithFields(msg) + '"' + '\n');
       return out;
    }
 
@@ -76,21 +111,28 @@ namespace g3 {
                  + "->" 
                  + msg.function() 
                  + ":" + msg.line() + "] ");
+      appendContext(out, msg);
       return out;
    }
 
 
+   // "timestamp LEVEL thread_id(thread_name) file->function:line] ", appended piece by piece
+   // into one string. The thread id and name were recorded when the message was made
    std::string LogMessage::FullLogDetailsToString(const LogMessage& msg) {
-      std::string out;
-      out.append(msg.timestamp() + " "
-                 + msg.level() 
-                 +  " " // " [" 
-                 + msg.threadID() 
-                 + " "
-                 + msg.file() 
-                 + "->"
-                 + msg.function() 
-                 + ":" + msg.line() + "] ");
+      std::string out = msg.timestamp();
+      out.reserve(out.size() + msg._level.text.size() + msg._thread_name.size() + msg._file.size()
+                  + msg._function.size() + 64);
+      out.append(" ").append(msg._level.text).append(" ");
+      char number[24];
+      auto result = std::to_chars(number, number + sizeof(number), msg._thread_id);
+      out.append(number, result.ptr);
+      if (!msg._thread_name.empty()) {
+         out.append("(").append(msg._thread_name).append(")");
+      }
+      out.append(" ").append(msg._file).append("->").append(msg._function).append(":");
+      result = std::to_chars(number, number + sizeof(number), msg._line);
+      out.append(number, result.ptr).append("] ");
+      appendContext(out, msg);
       return out;
    }
 
@@ -98,7 +140,7 @@ namespace g3 {
    // helper for normal
    std::string LogMessage::normalToString(const LogMessage& msg) {
       auto out = msg._logDetailsToStringFunc(msg);
-      out.append(msg.message() + '\n');
+      out.append(messageWithFields(msg) + '\n');
       return out;
    }
 
@@ -141,12 +183,15 @@ namespace g3 {
       auto out = _logDetailsToStringFunc(*this);
       static const std::string errorUnknown = {
          "UNKNOWN or Custom made Log Message Type" };
-      out.append("    *******" + errorUnknown + "\n    " + message() + '\n');
+      out.append("    *******" + errorUnknown + "\n    " + messageWithFields(*this) + '\n');
       return out;
    }
 
 
    std::string LogMessage::timestamp(const std::string& time_look) const {
+      if (0 != _ticks) {
+         materializeTimestamp();
+      }
       return g3::localtime_formatted(to_system_time(_timestamp), time_look);
    }
 
@@ -166,17 +211,119 @@ namespace g3 {
    LogMessage::LogMessage(std::string file, const int line,
                           std::string function, const LEVELS level)
       : _logDetailsToStringFunc(LogMessage::DefaultLogDetailsToString)
-      , _timestamp(std::chrono::high_resolution_clock::now())
+      , _ticks(0)
       , _call_thread_id(std::this_thread::get_id())
-#if defined(G3_LOG_FULL_FILENAME)
-      , _file(file)
-#else
-	  , _file(LogMessage::splitFileName(file))
-#endif
-      , _file_path(file)
+      , _thread_id(0)
       , _line(line)
-      , _function(function)
       , _level(level) {
+      stampTime();
+      stampThread();
+      storeDetails(file, function, {}, Details::Copy);
+   }
+
+
+   LogMessage::LogMessage(const char* file, const int line, const char* function, const LEVELS& level,
+                          const char* expression, std::string_view text, Details details)
+      : _logDetailsToStringFunc(LogMessage::DefaultLogDetailsToString)
+      , _ticks(0)
+      , _call_thread_id(std::this_thread::get_id())
+      , _thread_id(0)
+      , _line(line)
+      , _level(level)
+      , _message(text) {
+      stampTime();
+      stampThread();
+      storeDetails(file, function, (nullptr == expression) ? "" : expression, details);
+   }
+
+
+   LogMessage::LogMessage(const CallSite& site, const LEVELS& level, const char* expression, std::string_view text)
+      : _logDetailsToStringFunc(LogMessage::DefaultLogDetailsToString)
+      , _ticks(0)
+      , _call_thread_id(std::this_thread::get_id())
+      , _thread_id(0)
+      , _line(site.line)
+      , _level(level)
+      , _message(text) {
+      stampTime();
+      stampThread();
+      // the expression is the stringified CHECK(...) argument, part of the same binary as the call site
+      storeDetails(site.file_path, site.function, (nullptr == expression) ? "" : expression,
+                   site.referable() ? Details::Reference : Details::Copy, &site);
+   }
+
+
+   void LogMessage::reuse(const CallSite& site, const LEVELS& level, const char* expression, std::string_view text) {
+      _logDetailsToStringFunc = LogMessage::DefaultLogDetailsToString;
+      stampTime();
+      _call_thread_id = std::this_thread::get_id();
+      stampThread();
+      _line = site.line;
+      _level = level;
+      _message.assign(text.data(), text.size());
+      _arguments.clear();
+      _fields.clear();
+      _lazy.reset();
+      storeDetails(site.file_path, site.function, (nullptr == expression) ? "" : expression,
+                   site.referable() ? Details::Reference : Details::Copy, &site);
+   }
+
+
+   void LogMessage::reuse(const char* file, const int line, const char* function, const LEVELS& level,
+                          const char* expression, std::string_view text, Details details) {
+      _logDetailsToStringFunc = LogMessage::DefaultLogDetailsToString;
+      stampTime();
+      _call_thread_id = std::this_thread::get_id();
+      stampThread();
+      _line = line;
+      _level = level;
+      _message.assign(text.data(), text.size());
+      _arguments.clear();
+      _fields.clear();
+      _lazy.reset();
+      storeDetails(file, function, (nullptr == expression) ? "" : expression, details);
+   }
+
+
+   void LogMessage::reuse(const LogMessage& other) {
+      _logDetailsToStringFunc = other._logDetailsToStringFunc;
+      _timestamp = other._timestamp;
+      _ticks = other._ticks;
+      _call_thread_id = other._call_thread_id;
+      _thread_id = other._thread_id;
+      _thread_name = other._thread_name;
+      _context = other._context;
+      _details.assign(other._details);
+      _file = other._file;
+      _file_path = other._file_path;
+      _line = other._line;
+      _function = other._function;
+      _short_function = other._short_function;
+      _level = other._level;
+      _expression = other._expression;
+      _message.assign(other._message.data(), other._message.size());
+      _arguments.assign(other._arguments);
+      _fields.assign(other._fields);
+      _lazy = other._lazy;
+      relocateDetails(other._details.data(), other._details.size());
+   }
+
+
+   void LogMessage::recycle(size_t max_capacity) {
+      auto clear = [max_capacity](std::string& str) {
+         if (str.capacity() > max_capacity) {
+            std::string().swap(str);
+         } else {
+            str.clear();
+         }
+      };
+      _message.shrink(max_capacity);
+      clear(_arguments);
+      clear(_fields);
+      clear(_details);
+      _context.reset();
+      _lazy.reset();
+      _file = _file_path = _function = _short_function = _expression = std::string_view("");
    }
 
 
@@ -188,34 +335,154 @@ namespace g3 {
    LogMessage::LogMessage(const LogMessage& other)
       : _logDetailsToStringFunc(other._logDetailsToStringFunc)
       , _timestamp(other._timestamp)
+      , _ticks(other._ticks)
       , _call_thread_id(other._call_thread_id)
+      , _thread_id(other._thread_id)
+      , _thread_name(other._thread_name)
+      , _context(other._context)
+      , _details(other._details)
       , _file(other._file)
       , _file_path(other._file_path)
       , _line(other._line)
       , _function(other._function)
+      , _short_function(other._short_function)
       , _level(other._level)
       , _expression(other._expression)
-      , _message(other._message) {
+      , _message(other._message)
+      , _arguments(other._arguments)
+      , _fields(other._fields)
+      , _lazy(other._lazy) {
+      relocateDetails(other._details.data(), other._details.size());
    }
 
    LogMessage::LogMessage(LogMessage&& other) // Instances of LogMessage are MoveConstructible
       : _logDetailsToStringFunc(other._logDetailsToStringFunc)
       , _timestamp(other._timestamp)
+      , _ticks(other._ticks)
       , _call_thread_id(other._call_thread_id)
-      , _file(std::move(other._file))
-      , _file_path(std::move(other._file_path))
+      , _thread_id(other._thread_id)
+      , _thread_name(other._thread_name)
+      , _context(std::move(other._context))
+      , _file(other._file)
+      , _file_path(other._file_path)
       , _line(other._line)
-      , _function(std::move(other._function))
+      , _function(other._function)
+      , _short_function(other._short_function)
       , _level(other._level)
-      , _expression(std::move(other._expression))
-      , _message(std::move(other._message)) {
+      , _expression(other._expression)
+      , _message(std::move(other._message))
+      , _arguments(std::move(other._arguments))
+      , _fields(std::move(other._fields))
+      , _lazy(std::move(other._lazy)) {
+      const char* old_details = other._details.data();
+      const size_t old_size = other._details.size();
+      _details = std::move(other._details);
+      relocateDetails(old_details, old_size);
+
+      // the moved from message must not point into what is now ours
+      other._details.clear();
+      other._file = other._file_path = other._function = other._short_function = other._expression = std::string_view("");
+   }
+
+
+   // All the variable length details are kept in one string, which means one allocation
+   // per message instead of one per detail. With Details::Reference nothing is copied at all.
+   // A call site has the file name and the short function name worked out already, at compile time
+   void LogMessage::storeDetails(std::string_view file_path, std::string_view function,
+                                 std::string_view expression, Details details, const CallSite* site) {
+      const std::string_view file = (nullptr != site) ? site->file : internal::baseName(file_path);
+      const std::string_view short_function = (nullptr != site) ? site->short_function : internal::shortFunctionName(function);
+      const auto file_offset = static_cast<size_t>(file.data() - file_path.data());
+      const auto short_function_offset = static_cast<size_t>(short_function.data() - function.data());
+
+      if (Details::Reference == details) {
+         _details.clear();
+         _file_path = file_path;
+         _function = function;
+         _expression = expression;
+      } else {
+         const size_t size = file_path.size() + function.size() + expression.size();
+         if (pointsInto(file_path, _details) || pointsInto(function, _details) || pointsInto(expression, _details)) {
+            // the given views point into the current _details, so build a new block first
+            std::string block;
+            block.reserve(size);
+            block.append(file_path).append(function).append(expression);
+            _details.swap(block);
+         } else {
+            // keeps the memory of a reused message
+            _details.clear();
+            _details.reserve(size);
+            _details.append(file_path).append(function).append(expression);
+         }
+
+         const char* base = _details.data();
+         _file_path = std::string_view(base, file_path.size());
+         _function = std::string_view(base + file_path.size(), function.size());
+         _expression = std::string_view(base + file_path.size() + function.size(), expression.size());
+      }
+      _file = _file_path.substr(file_offset);
+      _short_function = _function.substr(short_function_offset, short_function.size());
+   }
+
+
+   // After _details was copied or moved from a block at 'old_details' the views that
+   // pointed into the old block must point to the same place in the new one
+   void LogMessage::relocateDetails(const char* old_details, size_t old_size) {
+      const char* base = _details.data();
+      if (base == old_details) {
+         return;
+      }
+      relocate(_file, old_details, old_size, base);
+      relocate(_file_path, old_details, old_size, base);
+      relocate(_function, old_details, old_size, base);
+      relocate(_short_function, old_details, old_size, base);
+      relocate(_expression, old_details, old_size, base);
+   }
+
+
+   void LogMessage::materializeArguments() const {
+      std::string arguments;
+      arguments.swap(_arguments);
+      internal::formatArguments(arguments, _message);
+   }
+
+
+   // A copy of a message that was not materialized shares the callable, it is still only called once
+   void LogMessage::materializeLazy() const {
+      _message.append(_lazy->text());
+      _lazy.reset();
+   }
+
+
+   // With G3_LOG_CLOCK_TSC the LOG call only reads the CPU counter, the conversion to a
+   // time point is left to the LogWorker. Zero is never a reading, it means converted
+   void LogMessage::stampTime() {
+#if defined(G3_LOG_CLOCK_TSC)
+      const uint64_t ticks = internal::cpuTicks();
+      _ticks = (0 == ticks) ? 1 : ticks;
+#else
+      _timestamp = internal::timestampNow();
+      _ticks = 0;
+#endif
+   }
+
+
+   void LogMessage::materializeTimestamp() const {
+      _timestamp = internal::ticksToTimePoint(_ticks);
+      _ticks = 0;
+   }
+
+
+   void LogMessage::stampThread() {
+      const auto& thread = internal::currentThreadInfo();
+      _thread_id = thread.id;
+      _thread_name = thread.name;
+      _context = currentContext();
    }
 
 
    std::string LogMessage::threadID() const {
-      std::ostringstream oss;
-      oss << _call_thread_id;
-      return oss.str();
+      return std::to_string(_thread_id);
    }
 
 
@@ -0,0 +1,181 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/logmessagepool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+   using MessageList = std::vector<std::unique_ptr<g3::LogMessage>>;
+
+   // messages move between the thread's own list and the depot this many at a time
+   const size_t kBatchSize = 32;
+
+   // more than this is not kept, a burst should not hold on to its memory for ever
+   const size_t kMaxPooled = 8192;
+
+   // a message that once held a huge text should not keep all that memory
+   const size_t kMaxRetainedCapacity = 16 * 1024;
+
+
+   struct Depot {
+      std::mutex mutex;
+      MessageList messages;
+      std::atomic<uint64_t> hits {0};
+      std::atomic<uint64_t> misses {0};
+      std::atomic<size_t> pooled {0};
+      std::atomic<int64_t> in_use {0};  // acquired and not yet released
+      std::atomic<int64_t> peak_in_use {0};
+
+      void addInUse(int64_t delta) {
+         const int64_t now = in_use.fetch_add(delta, std::memory_order_relaxed) + delta;
+         int64_t peak = peak_in_use.load(std::memory_order_relaxed);
+         while (now > peak && !peak_in_use.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+         }
+      }
+   };
+
+   // Never destroyed: threads that exit after main still give their messages back to it
+   Depot& depot() {
+      static Depot* instance = new Depot;
+      return *instance;
+   }
+
+   void toDepot(MessageList& from, size_t count) {
+      auto& shared = depot();
+      std::lock_guard<std::mutex> lock(shared.mutex);
+      while (count-- > 0 && !from.empty()) {
+         if (shared.messages.size() < kMaxPooled) {
+            shared.messages.push_back(std::move(from.back()));
+         }
+         from.pop_back(); // a message that did not fit is deleted here
+      }
+      shared.pooled.store(shared.messages.size(), std::memory_order_relaxed);
+   }
+
+   void fromDepot(MessageList& to, size_t count) {
+      auto& shared = depot();
+      std::lock_guard<std::mutex> lock(shared.mutex);
+      while (count-- > 0 && !shared.messages.empty()) {
+         to.push_back(std::move(shared.messages.back()));
+         shared.messages.pop_back();
+      }
+      shared.pooled.store(shared.messages.size(), std::memory_order_relaxed);
+   }
+
+
+   struct FreeList {
+      MessageList messages;
+      uint64_t hits = 0; // added to the depot's count in batches
+      int64_t in_use = 0; // acquired minus released by this thread, also added in batches
+      ~FreeList();
+
+      void flushHits() {
+         depot().hits.fetch_add(hits, std::memory_order_relaxed);
+         hits = 0;
+         flushInUse();
+      }
+
+      void flushInUse() {
+         depot().addInUse(in_use);
+         in_use = 0;
+      }
+
+      void countInUse(int64_t delta) {
+         in_use += delta;
+         if (in_use >= static_cast<int64_t>(kBatchSize) || in_use <= -static_cast<int64_t>(kBatchSize)) {
+            flushInUse();
+         }
+      }
+   };
+
+   // trivially destructible, so it is safe to read even after the free list below is gone.
+   // LOG calls from other thread_local destructors at thread exit then bypass the free list
+   thread_local bool t_free_list_destroyed = false;
+   thread_local FreeList t_free_list;
+
+   FreeList::~FreeList() {
+      t_free_list_destroyed = true;
+      flushHits();
+      toDepot(messages, messages.size());
+   }
+} // anonymous
+
+
+
+namespace g3 {
+   LogMessagePoolStats logMessagePoolStats() {
+      if (!t_free_list_destroyed) {
+         t_free_list.flushHits();
+      }
+      auto& shared = depot();
+      LogMessagePoolStats stats;
+      stats.hits = shared.hits.load(std::memory_order_relaxed);
+      stats.misses = shared.misses.load(std::memory_order_relaxed);
+      stats.high_watermark = static_cast<uint64_t>(shared.peak_in_use.load(std::memory_order_relaxed));
+      stats.pooled = shared.pooled.load(std::memory_order_relaxed);
+      return stats;
+   }
+
+
+   namespace internal {
+      std::unique_ptr<LogMessage> acquireLogMessage() {
+         if (t_free_list_destroyed) {
+            depot().addInUse(1);
+         } else {
+            auto& list = t_free_list;
+            list.countInUse(1);
+            if (list.messages.empty()) {
+               list.flushHits();
+               fromDepot(list.messages, kBatchSize);
+            }
+            if (!list.messages.empty()) {
+               ++list.hits;
+               auto message = std::move(list.messages.back());
+               list.messages.pop_back();
+               return message;
+            }
+         }
+         depot().misses.fetch_add(1, std::memory_order_relaxed);
+         return std::make_unique<LogMessage>("", 0, "", G3LOG_DEBUG, "", std::string_view(), LogMessage::Details::Reference);
+      }
+
+
+      void releaseLogMessage(std::unique_ptr<LogMessage> message) {
+         if (nullptr == message) {
+            return;
+         }
+         message->recycle(kMaxRetainedCapacity);
+         if (t_free_list_destroyed) {
+            depot().addInUse(-1);
+            MessageList single;
+            single.push_back(std::move(message));
+            toDepot(single, 1);
+            return;
+         }
+
+         auto& list = t_free_list;
+         list.countInUse(-1);
+         list.messages.push_back(std::move(message));
+         if (list.messages.size() >= 2 * kBatchSize) {
+            toDepot(list.messages, kBatchSize);
+         }
+      }
+
+
+      void LogMessageDeleter::operator()(LogMessage* message) const {
+         if (pooled) {
+            releaseLogMessage(std::unique_ptr<LogMessage>(message));
+         } else {
+            delete message;
+         }
+      }
+   } // internal
+} // g3
@@ -0,0 +1,146 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/logpreinit.hpp"
+#include "g3log/loglevels.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+   using g3::LogMessage;
+   using g3::internal::kPreInitMessages;
+   using MessageList = std::vector<std::unique_ptr<LogMessage>>;
+
+   // All constant initialized, a LOG call from any static initializer finds them ready, and
+   // trivially destructible, an exit handler can still use them
+   std::atomic<LogMessage*> g_ring[kPreInitMessages];
+   std::atomic<size_t> g_next {0}; // the messages ever put in the ring. The next goes to g_ring[g_next % size]
+   std::atomic<size_t> g_bytes {0}; // the message text in the ring
+   std::atomic<size_t> g_dropped {0};
+   std::atomic<bool> g_closed {false}; // set when the kept messages are taken, nothing is kept after that
+   std::once_flag g_exit_dump_flag;
+
+
+   size_t textBytes(const LogMessage& message) {
+      return message._message.size() + message._arguments.size();
+   }
+
+
+   void dumpAtExit() {
+      g3::internal::dumpPreInitMessages();
+   }
+
+
+   // Ends the keeping and takes the messages in the ring, oldest first. A LOG call that puts its
+   // message in the ring while this runs either has it taken here or sees g_closed and takes it
+   // back itself, see keepPreInitMessage. Both sides use sequentially consistent operations
+   // @return false if the keeping had already ended
+   bool takeAll(MessageList& messages) {
+      if (g_closed.exchange(true)) {
+         return false;
+      }
+      const size_t end = g_next.load();
+      const size_t begin = (end > kPreInitMessages) ? end - kPreInitMessages : 0;
+      messages.reserve(end - begin);
+      for (size_t index = begin; index < end; ++index) {
+         LogMessage* message = g_ring[index % kPreInitMessages].exchange(nullptr);
+         if (nullptr != message) {
+            messages.emplace_back(message);
+         }
+      }
+      return true;
+   }
+} // anonymous
+
+
+
+namespace g3 {
+   namespace internal {
+      std::unique_ptr<LogMessage> keepPreInitMessage(std::unique_ptr<LogMessage> message) {
+         if (g_closed.load()) {
+            return message;
+         }
+         std::call_once(g_exit_dump_flag, [] { std::atexit(dumpAtExit); });
+
+         const size_t bytes = textBytes(*message);
+         if (g_bytes.fetch_add(bytes) + bytes > kPreInitBytes) {
+            g_bytes.fetch_sub(bytes);
+            g_dropped.fetch_add(1);
+            return nullptr;
+         }
+         auto& slot = g_ring[g_next.fetch_add(1) % kPreInitMessages];
+         LogMessage* oldest = slot.exchange(message.release());
+         if (nullptr != oldest) {
+            g_bytes.fetch_sub(textBytes(*oldest));
+            g_dropped.fetch_add(1);
+            delete oldest;
+         }
+         if (g_closed.load()) {
+            // The keeping ended while the message was put in the ring. Whatever is in the slot
+            // now was not taken by the replay, it is given back to be saved by the caller
+            return std::unique_ptr<LogMessage>(slot.exchange(nullptr));
+         }
+         return nullptr;
+      }
+
+
+      LogMessageBatch replayPreInitMessages() {
+         MessageList kept;
+         MessageList batch;
+         if (takeAll(kept)) {
+            const size_t dropped = g_dropped.load();
+            if (dropped > 0) {
+               auto warning = std::make_unique<LogMessage>(__FILE__, __LINE__, __FUNCTION__, WARNING);
+               warning->write().append(std::to_string(dropped))
+               .append(" messages logged before g3::initializeLogging were dropped."
+                       " See G3_PREINIT_MESSAGES and G3_PREINIT_BYTES in Options.cmake");
+               batch.push_back(std::move(warning));
+            }
+            batch.reserve(batch.size() + kept.size());
+            for (auto& message : kept) {
+               batch.push_back(std::move(message));
+            }
+         }
+         return LogMessageBatch {std::move(batch)};
+      }
+
+
+      void dumpPreInitMessages() {
+         MessageList kept;
+         if (!takeAll(kept) || (kept.empty() && 0 == g_dropped.load())) {
+            return;
+         }
+         std::string text {"LOGGER NOT INITIALIZED. The messages logged before g3::initializeLogging:\n"};
+         for (const auto& message : kept) {
+            text.append(message->toString());
+         }
+         const size_t dropped = g_dropped.load();
+         if (dropped > 0) {
+            text.append(std::to_string(dropped)).append(" more messages were dropped\n");
+         }
+         std::cerr << text << std::flush;
+      }
+
+
+      void restartPreInitKeeping() {
+         g_closed.store(true);
+         for (auto& slot : g_ring) {
+            delete slot.exchange(nullptr);
+         }
+         g_next.store(0);
+         g_bytes.store(0);
+         g_dropped.store(0);
+         g_closed.store(false);
+      }
+   } // internal
+} // g3
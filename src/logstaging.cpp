@@ -0,0 +1,180 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/logstaging.hpp"
+#include "g3log/g3log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+   using MessageList = std::vector<std::unique_ptr<g3::LogMessage>>;
+
+   std::atomic<size_t> g_max_messages {g3::StagingThresholds{}.max_messages};
+   std::atomic<size_t> g_max_bytes {g3::StagingThresholds{}.max_bytes};
+   std::atomic<long long> g_max_delay_ms {g3::StagingThresholds{}.max_delay.count()};
+   // set when an empty staging area gets a message, cleared by the LogWorker's collection.
+   // An idle process is then not swept every max_delay. Written once per batch, not per message
+   std::atomic<bool> g_staged {false};
+
+   struct StagingArea;
+
+   // all staging areas, for the collection by the LogWorker and the flush at shutdown and fatal
+   struct Registry {
+      std::mutex mutex;
+      std::vector<StagingArea*> areas;
+   };
+
+   // Never destroyed: threads that exit after main still unregister their areas
+   Registry& registry() {
+      static Registry* instance = new Registry;
+      return *instance;
+   }
+
+   // set when the thread's staging area is destroyed, a trivial thread_local outlives it
+   thread_local bool t_area_destroyed = false;
+
+   // Locks: the registry before an area, an area before the LogWorker queue
+   struct StagingArea {
+      std::mutex mutex;
+      MessageList messages;
+      size_t bytes = 0;
+
+      StagingArea() {
+         auto& all = registry();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         all.areas.push_back(this);
+      }
+
+      // the thread exits, what is left goes to the LogWorker
+      ~StagingArea() {
+         auto& all = registry();
+         std::lock_guard<std::mutex> registry_lock(all.mutex);
+         all.areas.erase(std::remove(all.areas.begin(), all.areas.end(), this), all.areas.end());
+         std::lock_guard<std::mutex> lock(mutex);
+         publish();
+         t_area_destroyed = true;
+      }
+
+      // Called with the mutex held: the batch is on the LogWorker queue before any later
+      // message of the thread can be, so the order of the thread's messages is kept
+      template <typename Push>
+      void publish(const Push& push) {
+         if (messages.empty()) {
+            return;
+         }
+         MessageList batch;
+         batch.swap(messages);
+         messages.reserve(batch.size());
+         bytes = 0;
+         push(g3::LogMessageBatch {std::move(batch)});
+      }
+
+      void publish() {
+         publish(g3::internal::pushBatchToLogger);
+      }
+   };
+
+   // Locks the registry and every area, or with 'fatal' only those that are free
+   template <typename Push>
+   void publishAll(bool fatal, const Push& push) {
+      auto& all = registry();
+      std::unique_lock<std::mutex> registry_lock(all.mutex, std::defer_lock);
+      if (fatal) {
+         if (!registry_lock.try_lock()) {
+            return;
+         }
+      } else {
+         registry_lock.lock();
+      }
+
+      for (auto area : all.areas) {
+         std::unique_lock<std::mutex> lock(area->mutex, std::defer_lock);
+         if (fatal) {
+            if (!lock.try_lock()) {
+               continue;
+            }
+         } else {
+            lock.lock();
+         }
+         area->publish(push);
+      }
+   }
+
+   StagingArea& threadArea() {
+      thread_local StagingArea area;
+      return area;
+   }
+} // anonymous
+
+
+namespace g3 {
+   void flushStagedMessages() {
+      internal::flushAllStagedMessages();
+   }
+
+
+   namespace only_change_at_initialization {
+      void setStagingThresholds(const StagingThresholds& thresholds) {
+         g_max_messages.store(thresholds.max_messages, std::memory_order_relaxed);
+         g_max_bytes.store(thresholds.max_bytes, std::memory_order_relaxed);
+         g_max_delay_ms.store(thresholds.max_delay.count(), std::memory_order_relaxed);
+      }
+   } // only_change_at_initialization
+
+
+   StagingThresholds stagingThresholds() {
+      StagingThresholds thresholds;
+      thresholds.max_messages = g_max_messages.load(std::memory_order_relaxed);
+      thresholds.max_bytes = g_max_bytes.load(std::memory_order_relaxed);
+      thresholds.max_delay = std::chrono::milliseconds(g_max_delay_ms.load(std::memory_order_relaxed));
+      return thresholds;
+   }
+
+
+   namespace internal {
+      void stageMessage(std::unique_ptr<LogMessage> message) {
+         if (t_area_destroyed) {
+            // logged from another thread_local's destructor, after the area is gone
+            MessageList single;
+            single.push_back(std::move(message));
+            pushBatchToLogger(LogMessageBatch {std::move(single)});
+            return;
+         }
+
+         auto& area = threadArea();
+         std::lock_guard<std::mutex> lock(area.mutex); // only contended while the area is collected
+         if (area.messages.empty() && !g_staged.load(std::memory_order_relaxed)) {
+            g_staged.store(true, std::memory_order_relaxed);
+         }
+         area.bytes += message->_message.size() + message->_arguments.size();
+         area.messages.push_back(std::move(message));
+         if (area.messages.size() >= g_max_messages.load(std::memory_order_relaxed)
+               || area.bytes >= g_max_bytes.load(std::memory_order_relaxed)) {
+            area.publish();
+         }
+      }
+
+
+      void flushAllStagedMessages(bool fatal) {
+         publishAll(fatal, pushBatchToLogger);
+      }
+
+
+      void collectStagedMessages(const BatchPush& push) {
+         // Set under the area's lock, after it the message is found by the sweep that follows.
+         // A message staged after the exchange sets it again for the next collection
+         if (!g_staged.load(std::memory_order_relaxed) || !g_staged.exchange(false, std::memory_order_relaxed)) {
+            return;
+         }
+         publishAll(false, push);
+      }
+   } // internal
+} // g3
@@ -0,0 +1,291 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/logstream.hpp"
+
+#include <locale>
+#include <memory>
+#include <vector>
+#include <limits>
+
+namespace {
+   const size_t kInitialCapacity = 256;
+
+   // A deferred hex dump is written by the worker this many bytes at a time, see formatArguments
+   const size_t kHexDumpChunk = 512;
+
+   // A thread that once logged a huge dump should not keep that memory around for ever
+   const size_t kMaxRetainedCapacity = 64 * 1024;
+
+
+   /// The per thread LogStream cache. Index 0 is used by the normal LOG call,
+   /// higher indexes only when LOG calls are nested on the same thread.
+   struct LogStreamCache {
+      std::vector<std::unique_ptr<g3::LogStream>> streams;
+      size_t depth = 0;
+      ~LogStreamCache();
+   };
+
+   // trivially destructible, so it is safe to read even after the cache below is gone.
+   // LOG calls from other thread_local destructors at thread exit will then fall back
+   // to a stream that is not cached
+   thread_local bool t_cache_destroyed = false;
+   thread_local LogStreamCache t_cache;
+
+   LogStreamCache::~LogStreamCache() {
+      t_cache_destroyed = true;
+   }
+} // anonymous
+
+
+
+namespace g3 {
+   namespace internal {
+
+      LogStreamBuf::LogStreamBuf() {
+         _buffer.resize(kInitialCapacity);
+         setp(&_buffer[0], &_buffer[0] + _buffer.size());
+      }
+
+
+      void LogStreamBuf::reset() {
+         if (_buffer.size() > kMaxRetainedCapacity) {
+            std::string(kInitialCapacity, '\0').swap(_buffer);
+         }
+         setp(&_buffer[0], &_buffer[0] + _buffer.size());
+      }
+
+
+      const char* LogStreamBuf::c_str() {
+         // the terminating '\0' is not part of the content, it is not committed
+         *reserve(1) = '\0';
+         return pbase();
+      }
+
+
+      void LogStreamBuf::grow(size_t extra) {
+         const size_t used = size();
+         const size_t needed = used + extra;
+         size_t capacity = _buffer.size() * 2;
+         if (capacity < needed) {
+            capacity = needed;
+         }
+         _buffer.resize(capacity);
+         setp(&_buffer[0], &_buffer[0] + _buffer.size());
+         advance(used);
+      }
+
+
+      void LogStreamBuf::advance(size_t count) {
+         // std::streambuf::pbump only takes an int
+         const size_t kMaxBump = static_cast<size_t>(std::numeric_limits<int>::max());
+         while (count > kMaxBump) {
+            pbump(static_cast<int>(kMaxBump));
+            count -= kMaxBump;
+         }
+         pbump(static_cast<int>(count));
+      }
+
+
+      // Called by std::ostream when the put area is full
+      LogStreamBuf::int_type LogStreamBuf::overflow(int_type ch) {
+         if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+         }
+         const char c = traits_type::to_char_type(ch);
+         append(&c, 1);
+         return ch;
+      }
+
+
+      std::streamsize LogStreamBuf::xsputn(const char* s, std::streamsize count) {
+         if (count > 0) {
+            append(s, static_cast<size_t>(count));
+         }
+         return count;
+      }
+
+
+
+      // The record is produced by a LogStream in the same process, it is trusted to be
+      // complete. Reading is still bounds checked so a broken record can never read outside
+      void formatArguments(std::string_view record, MessageBuffer& out) {
+         const char* read = record.data();
+         const char* end = read + record.size();
+         auto take = [&](void* value, size_t size) {
+            if (static_cast<size_t>(end - read) < size) {
+               read = end;
+               return false;
+            }
+            std::memcpy(value, read, size);
+            read += size;
+            return true;
+         };
+
+         char digits[64];
+         while (read < end) {
+            const auto tag = static_cast<ArgumentTag>(*read++);
+            switch (tag) {
+               case ArgumentTag::Text: {
+                  uint32_t length = 0;
+                  if (take(&length, sizeof(length))) {
+                     const size_t available = static_cast<size_t>(end - read);
+                     const size_t count = (length < available) ? length : available;
+                     out.append(read, count);
+                     read += count;
+                  }
+                  break;
+               }
+               case ArgumentTag::Signed: {
+                  int64_t value = 0;
+                  if (take(&value, sizeof(value))) {
+                     auto result = std::to_chars(digits, digits + sizeof(digits), value);
+                     out.append(digits, static_cast<size_t>(result.ptr - digits));
+                  }
+                  break;
+               }
+               case ArgumentTag::Unsigned: {
+                  uint64_t value = 0;
+                  if (take(&value, sizeof(value))) {
+                     auto result = std::to_chars(digits, digits + sizeof(digits), value);
+                     out.append(digits, static_cast<size_t>(result.ptr - digits));
+                  }
+                  break;
+               }
+               case ArgumentTag::Floating: {
+                  int8_t precision = 0;
+                  double value = 0;
+                  if (take(&precision, sizeof(precision)) && take(&value, sizeof(value))) {
+#if defined(__cpp_lib_to_chars)
+                     auto result = std::to_chars(digits, digits + sizeof(digits), value,
+                                                 std::chars_format::general, precision);
+                     out.append(digits, static_cast<size_t>(result.ptr - digits));
+#else
+                     // never written without std::to_chars support, see LogStream::write_floating
+                     out.append(std::to_string(value));
+#endif
+                  }
+                  break;
+               }
+               case ArgumentTag::HexDump: {
+                  uint64_t total = 0;
+                  uint32_t size = 0;
+                  if (take(&total, sizeof(total)) && take(&size, sizeof(size))) {
+                     const size_t available = static_cast<size_t>(end - read);
+                     const size_t count = (size < available) ? size : available;
+                     const auto* bytes = reinterpret_cast<const unsigned char*>(read);
+                     read += count;
+
+                     char text[hexDumpLength(kHexDumpChunk)];
+                     out.append(text, static_cast<size_t>(writeHexDumpHeader(text, count, total) - text));
+                     for (size_t done = 0; done < count; done += kHexDumpChunk) {
+                        const size_t chunk = (count - done < kHexDumpChunk) ? count - done : kHexDumpChunk;
+                        char* written = writeHexDumpLines(text, bytes + done, chunk, done);
+                        out.append(text, static_cast<size_t>(written - text));
+                     }
+                  }
+                  break;
+               }
+               default:
+                  // unknown tag, the rest of the record cannot be trusted
+                  out.append("[...corrupt deferred log record...]");
+                  return;
+            }
+         }
+      }
+   } // internal
+
+
+
+   LogStream::LogStream() : std::ostream(nullptr) {
+      rdbuf(&_buf);
+      // Log entries should look the same whatever global locale the application is using
+      imbue(std::locale::classic());
+   }
+
+
+   void LogStream::reset() {
+      _buf.reset();
+      _fields.clear();
+      _deferred = false;
+      _text_start = kNoText;
+      clear();
+      flags(std::ios_base::skipws | std::ios_base::dec);
+      precision(6);
+      width(0);
+      fill(' ');
+   }
+
+
+   LogStream& LogStream::operator<<(const HexDump& dump) {
+      if (_deferred && dump.size <= std::numeric_limits<uint32_t>::max()) {
+         closeText();
+         const auto total = static_cast<uint64_t>(dump.total);
+         const auto size = static_cast<uint32_t>(dump.size);
+         char* out = _buf.reserve(1 + sizeof(total) + sizeof(size) + size);
+         *out++ = static_cast<char>(internal::ArgumentTag::HexDump);
+         std::memcpy(out, &total, sizeof(total));
+         std::memcpy(out + sizeof(total), &size, sizeof(size));
+         if (size > 0) {
+            std::memcpy(out + sizeof(total) + sizeof(size), dump.data, size);
+         }
+         _buf.commit(1 + sizeof(total) + sizeof(size) + size);
+         return *this;
+      }
+      openText();
+      char* out = _buf.reserve(internal::hexDumpLength(dump.size));
+      char* end = internal::writeHexDumpHeader(out, dump.size, dump.total);
+      end = internal::writeHexDumpLines(end, dump.data, dump.size, 0);
+      _buf.commit(static_cast<size_t>(end - out));
+      return *this;
+   }
+
+
+   LogStream& LogStream::operator<<(const char* value) {
+      if (nullptr == value) {
+         // let std::ostream deal with it the standard way (badbit)
+         static_cast<std::ostream&>(*this) << value;
+         return *this;
+      }
+      return write_text(value, std::strlen(value));
+   }
+
+
+
+   namespace internal {
+      LogStream* acquireLogStream() {
+         if (t_cache_destroyed) {
+            return new LogStream();
+         }
+
+         auto& cache = t_cache;
+         if (cache.depth == cache.streams.size()) {
+            cache.streams.push_back(std::make_unique<LogStream>());
+         }
+         LogStream* stream = cache.streams[cache.depth++].get();
+         stream->reset();
+         return stream;
+      }
+
+
+      void releaseLogStream(LogStream* stream) {
+         if (t_cache_destroyed) {
+            delete stream;
+            return;
+         }
+
+         auto& cache = t_cache;
+         if (cache.depth > 0 && cache.streams[cache.depth - 1].get() == stream) {
+            --cache.depth;
+            return;
+         }
+         // Not from the cache (acquired while the cache was being torn down)
+         delete stream;
+      }
+   } // internal
+} // g3
@@ -8,6 +8,9 @@
 
 #include "g3log/logworker.hpp"
 #include "g3log/logmessage.hpp"
+#include "g3log/logmessagepool.hpp"
+#include "g3log/clock.hpp"
+#include "g3log/logstaging.hpp"
 #include "g3log/active.hpp"
 #include "g3log/g3log.hpp"
 #include "g3log/future.hpp"
@@ -17,35 +20,73 @@
 
 namespace g3 {
 
+#ifdef G3_LOG_STAGING
+   namespace {
+      std::chrono::milliseconds stagingCollectionPeriod() {
+         const auto delay = stagingThresholds().max_delay;
+         return (delay.count() > 0) ? delay : std::chrono::milliseconds(1);
+      }
+   } // anonymous
+
+   // the background thread also collects the staged messages of threads that went quiet,
+   // see g3log/logstaging.hpp. They are put straight on its own queue: the pointer to the
+   // initialized logger is not used by the background thread, it is reset when logging is shut down
+   LogWorkerImpl::LogWorkerImpl()
+      : _bg(kjellkod::Active::createActive([this](kjellkod::Active& self) {
+         if (!_collect_staged.load(std::memory_order_acquire)) {
+            return;
+         }
+         internal::collectStagedMessages([this, &self](LogMessageBatch batch) {
+            self.send([this, batch] { bgSaveBatch(batch); });
+         });
+      }, stagingCollectionPeriod())) { }
+#else
    LogWorkerImpl::LogWorkerImpl() : _bg(kjellkod::Active::createActive()) { }
+#endif
 
    // typedef MoveOnCopy<std::unique_ptr<LogMessage>> LogMessagePtr;
    void LogWorkerImpl::bgSave(g3::LogMessagePtr msgPtr) {
-      std::unique_ptr<LogMessage> uniqueMsg(std::move(msgPtr.get()));
-
-      for (auto& sink : _sinks) {
-         // LogMessage::LogMessage(const LogMessage& other)
-         // *(uniqueMsg) returns a reference to the managed LogMessage object
-         // copy construct a new LogMessage object on the stack
-         LogMessage msg(*(uniqueMsg));
-         // typedef MoveOnCopy<LogMessage> LogMessageMover;
-         // template<typename Moveable>
-         // explicit MoveOnCopy<Moveable>::MoveOnCopy(Moveable &&m);
-         sink->send(LogMessageMover(std::move(msg)));
-      }
+#ifdef G3_LOG_MESSAGE_POOL
+      // the message came from the pool and whoever is done with it last gives it back
+      const internal::LogMessageDeleter deleter {true};
+#else
+      const internal::LogMessageDeleter deleter {false};
+#endif
+      LogMessageMover::Owner uniqueMsg(msgPtr.get().release(), deleter);
+      // keeps the conversion of the time stamps to wall clock time accurate
+      internal::refreshClockCalibration();
+      // format any deferred arguments once, here, and not once per sink copy
+      uniqueMsg->materialize();
 
       if (_sinks.empty()) {
          std::string err_msg {"g3logworker has no sinks. Message: ["};
          err_msg.append(uniqueMsg.get()->toString()).append("]\n");
          std::cerr << err_msg;
+         return;
       }
-   } // uniqueMsg that goes out of this scope will dispose of the LogMessage 
-     // object dynamically-allocated through std::make_unique<LogMessage>(...) 
-     // in g3log.cpp::saveMessage and the LogMessage object will be destroyed 
-     // immediately.
+
+      // every sink but the last gets a copy, the last sink gets the original
+      const size_t last = _sinks.size() - 1;
+      for (size_t index = 0; index < last; ++index) {
+#ifdef G3_LOG_MESSAGE_POOL
+         // the copy is made in a recycled message, the sink gives it back to the pool
+         LogMessageMover::Owner msg(internal::acquireLogMessage().release(), deleter);
+         msg->reuse(*(uniqueMsg));
+#else
+         // LogMessage::LogMessage(const LogMessage& other)
+         // *(uniqueMsg) returns a reference to the managed LogMessage object
+         LogMessageMover::Owner msg(new LogMessage(*(uniqueMsg)), deleter);
+#endif
+         _sinks[index]->send(LogMessageMover(std::move(msg)));
+      }
+      _sinks[last]->send(LogMessageMover(std::move(uniqueMsg)));
+   } // uniqueMsg is handed to the last sink, which disposes of the LogMessage
+     // object dynamically-allocated through std::make_unique<LogMessage>(...)
+     // in g3log.cpp::saveMessage when it is done with it. Only without sinks is
+     // the LogMessage object destroyed here, when uniqueMsg goes out of scope.
      // uniqueMsg owns and manages this dynamic LogMessage object by a series
      // of ownership transfers from:
-     //    <- std::unique_ptr<LogMessage> uniqueMsg(std::move(msgPtr.get()))
+     //    <- LogMessageMover::Owner uniqueMsg(msgPtr.get().release(), deleter)
      //    <- LogWorkerImpl::bgSave(g3::LogMessagePtr msgPtr)
      //    <- LogWorker::save(LogMessagePtr msg)
      //    <- pushMessageToLogger(LogMessagePtr incoming)
@@ -55,6 +96,12 @@ namespace g3 {
      //                   const char* stack_trace)
      // The same is true with uniqueMsg in LogWorkerImpl::bgFatal
 
+   void LogWorkerImpl::bgSaveBatch(LogMessageBatch batch) {
+      for (auto& message : batch.get()) {
+         bgSave(LogMessagePtr {std::move(message)});
+      }
+   }
+
    // typedef MoveOnCopy<std::unique_ptr<FatalMessage>> FatalMessagePtr;
    // struct FatalMessage : public LogMessage { ... }
    void LogWorkerImpl::bgFatal(FatalMessagePtr msgPtr) {
@@ -95,6 +142,11 @@ namespace g3 {
    }
 
    LogWorker::~LogWorker() {
+      // No collection of staged messages is in progress on the background thread after this,
+      // nor is a new one started. Messages still staged are flushed by shutDownLogging below
+      auto token_stopped = g3::spawn_task([this] { _impl._collect_staged.store(false); }, _impl._bg.get());
+      token_stopped.wait();
+
       g3::internal::shutDownLoggingForActiveOnly(this);
 
       // The sinks WILL automatically be cleared at exit of this destructor
@@ -129,6 +181,14 @@ namespace g3 {
       _impl._bg->send([this, msg] {_impl.bgSave(msg); });
    }
 
+   void LogWorker::saveBatch(LogMessageBatch entries) {
+      _impl._bg->send([this, entries] {_impl.bgSaveBatch(entries); });
+   }
+
+   void LogWorker::setStagingCollection(bool enabled) {
+      _impl._collect_staged.store(enabled, std::memory_order_release);
+   }
+
    void LogWorker::fatal(FatalMessagePtr fatal_message) {
       _impl._bg->send([this, fatal_message] {_impl.bgFatal(fatal_message); });
    }
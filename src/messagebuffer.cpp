@@ -0,0 +1,73 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/messagebuffer.hpp"
+
+namespace g3 {
+
+   MessageBuffer::MessageBuffer(MessageBuffer&& other) noexcept : MessageBuffer() {
+      *this = std::move(other);
+   }
+
+
+   // a heap buffer changes owner. Inline text has to be copied, which is cheap since it is short
+   MessageBuffer& MessageBuffer::operator=(MessageBuffer&& other) noexcept {
+      if (this == &other) {
+         return *this;
+      }
+      if (other._is_inline) {
+         std::memcpy(_inline, other._inline, other._size + 1);
+         _size = other._size;
+         std::string().swap(_heap);
+         _is_inline = true;
+      } else {
+         _heap.swap(other._heap);
+         _is_inline = false;
+         std::string().swap(other._heap);
+         other._is_inline = true;
+      }
+      other.clear();
+      return *this;
+   }
+
+
+   MessageBuffer& MessageBuffer::append(size_t count, char c) {
+      reserve(size() + count);
+      if (!_is_inline) {
+         _heap.append(count, c);
+         return *this;
+      }
+      std::memset(_inline + _size, c, count);
+      _size += count;
+      _inline[_size] = '\0';
+      return *this;
+   }
+
+
+   // the text might be a part of this buffer
+   MessageBuffer& MessageBuffer::assign(const char* text, size_t count) {
+      if (!_is_inline) {
+         _heap.assign(text, count);
+      } else if (count <= kInlineSize - 1) {
+         std::memmove(_inline, text, count);
+         _size = count;
+         _inline[_size] = '\0';
+      } else {
+         _heap.assign(text, count); // longer than the inline text: not a part of it
+         _is_inline = false;
+      }
+      return *this;
+   }
+
+
+   void MessageBuffer::spill(size_t capacity) {
+      _heap.reserve((capacity < _size) ? _size : capacity);
+      _heap.assign(_inline, _size);
+      _is_inline = false;
+   }
+} // g3
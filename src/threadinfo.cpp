@@ -0,0 +1,94 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/threadinfo.hpp"
+
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__FreeBSD__)
+#include <pthread.h>
+#include <pthread_np.h>
+#endif
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+   uint64_t systemThreadId() {
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+      return static_cast<uint64_t>(GetCurrentThreadId());
+#elif defined(__APPLE__)
+      uint64_t id = 0;
+      pthread_threadid_np(nullptr, &id);
+      return id;
+#elif defined(__linux__)
+      return static_cast<uint64_t>(syscall(SYS_gettid));
+#elif defined(__FreeBSD__)
+      return static_cast<uint64_t>(pthread_getthreadid_np());
+#else
+      return static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+   }
+
+   // Messages refer to the names, and can be written after their thread is gone.
+   // So the names are kept for ever, each one once. Never destroyed, like the names
+   std::string_view keep(std::string_view name) {
+      static std::mutex* mutex = new std::mutex;
+      static auto* names = new std::unordered_set<std::string>;
+      std::lock_guard<std::mutex> lock(*mutex);
+      return *names->emplace(name).first;
+   }
+
+   void nameSystemThread(std::string_view name) {
+#if defined(__APPLE__)
+      pthread_setname_np(std::string(name).c_str());
+#elif defined(__linux__)
+      // at most 15 characters, or the call fails
+      pthread_setname_np(pthread_self(), std::string(name.substr(0, 15)).c_str());
+#elif defined(__FreeBSD__)
+      pthread_set_name_np(pthread_self(), std::string(name).c_str());
+#else
+      (void)name; // Windows' SetThreadDescription is not available on all supported versions
+#endif
+   }
+
+   g3::internal::ThreadInfo& threadInfo() {
+      thread_local g3::internal::ThreadInfo info {systemThreadId(), {}};
+      return info;
+   }
+} // anonymous
+
+
+
+namespace g3 {
+   void setThreadName(std::string_view name) {
+      threadInfo().name = keep(name);
+      nameSystemThread(name);
+   }
+
+
+   std::string_view threadName() {
+      return threadInfo().name;
+   }
+
+
+   namespace internal {
+      const ThreadInfo& currentThreadInfo() {
+         return threadInfo();
+      }
+   } // internal
+} // g3
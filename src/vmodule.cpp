@@ -0,0 +1,210 @@
+/** ==========================================================================
+ * 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+ * with no warranties. This code is yours to share, use and modify with no
+ * strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+ * ============================================================================*/
+
+#include "g3log/vmodule.hpp"
+
+#if defined(G3_LOG_VMODULE)
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+   struct ModuleRule {
+      std::string pattern;
+      int32_t minimum;
+   };
+
+   // The rules in use. Changed, and matched against the call sites, with the mutex held
+   struct ModuleRules {
+      std::mutex mutex;
+      std::string text;
+      std::vector<ModuleRule> rules;
+   };
+
+   // Never destroyed: LOG calls made after main still find their rules
+   ModuleRules& moduleRules() {
+      static ModuleRules* instance = new ModuleRules;
+      return *instance;
+   }
+
+   std::string trimmed(const std::string& text) {
+      const auto first = text.find_first_not_of(" \t");
+      if (std::string::npos == first) {
+         return {};
+      }
+      const auto last = text.find_last_not_of(" \t");
+      return text.substr(first, last - first + 1);
+   }
+
+   std::string upperCase(std::string text) {
+      std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+         return static_cast<char>(std::toupper(c));
+      });
+      return text;
+   }
+
+   // '*' matches any characters, '?' one character. Backtracks to the last '*' on a mismatch
+   bool globMatch(const std::string& pattern, const std::string& text, size_t start) {
+      size_t p = 0;
+      size_t t = start;
+      size_t star = std::string::npos;
+      size_t star_text = 0;
+      while (t < text.size()) {
+         if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+         } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_text = t;
+         } else if (std::string::npos != star) {
+            p = star + 1;
+            t = ++star_text;
+         } else {
+            return false;
+         }
+      }
+      while (p < pattern.size() && pattern[p] == '*') {
+         ++p;
+      }
+      return p == pattern.size();
+   }
+
+   // The pattern is matched against the end of the path, from the start of any of its names
+   bool matchesPath(const std::string& pattern, std::string_view file_path) {
+      std::string path(file_path);
+      std::replace(path.begin(), path.end(), '\\', '/');
+      for (size_t start = 0; start < path.size(); ++start) {
+         if ((0 == start || path[start - 1] == '/') && globMatch(pattern, path, start)) {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   bool parseLevel(const std::string& name, int32_t& value) {
+      const std::string upper = upperCase(name);
+      const std::pair<const char*, const LEVELS&> known[] = {
+         {"DEBUG", G3LOG_DEBUG}, {"INFO", INFO}, {"WARNING", WARNING}, {"FATAL", FATAL}};
+      for (const auto& level : known) {
+         if (upper == level.first || upper == upperCase(level.second.text)) {
+            value = level.second.value;
+            return true;
+         }
+      }
+#ifdef G3_DYNAMIC_LOGGING
+      for (const auto& level : g3::log_levels::getAll()) {
+         if (upper == upperCase(level.second.level.text)) {
+            value = level.second.level.value;
+            return true;
+         }
+      }
+#endif
+
+      char* end = nullptr;
+      errno = 0;
+      const long number = std::strtol(name.c_str(), &end, 10);
+      if (name.empty() || '\0' != *end || ERANGE == errno
+            || number <= g3::internal::kNoModuleRule || number > std::numeric_limits<int32_t>::max()) {
+         return false;
+      }
+      value = static_cast<int32_t>(number);
+      return true;
+   }
+
+   bool parseRules(const std::string& text, std::vector<ModuleRule>& rules, std::string& error) {
+      size_t begin = 0;
+      while (begin <= text.size()) {
+         size_t end = text.find(',', begin);
+         if (std::string::npos == end) {
+            end = text.size();
+         }
+         const std::string rule = trimmed(text.substr(begin, end - begin));
+         begin = end + 1;
+         if (rule.empty()) {
+            continue;
+         }
+
+         const auto equal = rule.find('=');
+         if (std::string::npos == equal) {
+            error = "missing '=' in the module rule \"" + rule + "\"";
+            return false;
+         }
+         std::string pattern = trimmed(rule.substr(0, equal));
+         const std::string level = trimmed(rule.substr(equal + 1));
+         if (pattern.empty()) {
+            error = "missing file pattern in the module rule \"" + rule + "\"";
+            return false;
+         }
+         int32_t minimum = 0;
+         if (!parseLevel(level, minimum)) {
+            error = "unknown level \"" + level + "\" in the module rule \"" + rule + "\"";
+            return false;
+         }
+         std::replace(pattern.begin(), pattern.end(), '\\', '/');
+         rules.push_back(ModuleRule {pattern, minimum});
+      }
+      return true;
+   }
+} // anonymous
+
+
+namespace g3 {
+   bool setVModule(const std::string& rules, std::string* error) {
+      std::vector<ModuleRule> parsed;
+      std::string parse_error;
+      if (!parseRules(rules, parsed, parse_error)) {
+         if (error) {
+            *error = parse_error;
+         }
+         return false;
+      }
+
+      auto& all = moduleRules();
+      std::lock_guard<std::mutex> lock(all.mutex);
+      all.rules.swap(parsed);
+      all.text = rules;
+      // the call sites match their files again at their next LOG call
+      internal::g_vmodule_generation.fetch_add(1, std::memory_order_relaxed);
+      return true;
+   }
+
+
+   std::string vModule() {
+      auto& all = moduleRules();
+      std::lock_guard<std::mutex> lock(all.mutex);
+      return all.text;
+   }
+
+
+   namespace internal {
+      std::atomic<uint32_t> g_vmodule_generation {0};
+
+      uint64_t refreshModuleRule(const CallSite& site) {
+         auto& all = moduleRules();
+         std::lock_guard<std::mutex> lock(all.mutex);
+         // read with the lock held: the rules below are at least as new as the generation
+         const uint32_t generation = g_vmodule_generation.load(std::memory_order_relaxed);
+         int32_t minimum = kNoModuleRule;
+         for (const auto& rule : all.rules) {
+            if (matchesPath(rule.pattern, site.file_path)) {
+               minimum = rule.minimum;
+               break;
+            }
+         }
+         const uint64_t word = (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(minimum);
+         site.module_rule.store(word, std::memory_order_relaxed);
+         return word;
+      }
+   } // internal
+} // g3
+#endif // G3_LOG_VMODULE
@@ -46,6 +46,18 @@
       target_link_libraries(g3log-performance-threaded_worst  
                             ${G3LOG_LIBRARY}  ${PLATFORM_LINK_LIBRIES})
 
+      # LOGF FORMATTING ENGINES: snprintf vs tz_snprintf, see G3_LOGF_BACKEND
+      add_executable(g3log-performance-format_string
+                     ${DIR_PERFORMANCE}/main_format_string.cpp)
+      target_link_libraries(g3log-performance-format_string
+                            ${G3LOG_LIBRARY}  ${PLATFORM_LINK_LIBRIES})
+
+      # NOT TAKEN LOG CALLS IN A HOT LOOP: time and code size, see G3_COLD in g3log/attributes.hpp
+      add_executable(g3log-performance-cold_path
+                     ${DIR_PERFORMANCE}/main_cold_path.cpp)
+      target_link_libraries(g3log-performance-cold_path
+                            ${G3LOG_LIBRARY}  ${PLATFORM_LINK_LIBRIES})
+
    ELSE()
       message( STATUS "-DADD_G3LOG_BENCH_PERFORMANCE=OFF" )
    ENDIF(ADD_G3LOG_BENCH_PERFORMANCE)
@@ -0,0 +1,129 @@
+/** ==========================================================================
+* 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+* with no warranties. This code is yours to share, use and modify with no
+* strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+* ============================================================================*/
+
+// What LOG calls that are not taken cost a hot loop, see G3_COLD in g3log/attributes.hpp.
+// Two loops do the same arithmetic, one of them with 32 LOG_IF calls whose condition is
+// false at runtime. The time per iteration and, on Linux, the size of the loop's code are
+// compared. The log calls should add little more than a compare and a not taken branch each,
+// the code that builds the messages should be in the loop's cold part (GCC: "name.cold")
+#include "g3log/g3log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#if defined(__linux__)
+#include <elf.h>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#endif
+
+namespace {
+   volatile bool g_log_it = false; // never set, but the compiler cannot know that
+
+   double nanosecondsPerIteration(uint64_t (*loop)(uint64_t), uint64_t iterations, uint64_t& checksum) {
+      double best = 0;
+      for (int round = 0; round < 5; ++round) {
+         const auto start = std::chrono::steady_clock::now();
+         checksum += loop(iterations);
+         const auto elapsed = std::chrono::steady_clock::now() - start;
+         const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+                           / static_cast<double>(iterations);
+         best = (round == 0) ? ns : std::min(best, ns);
+      }
+      return best;
+   }
+
+#if defined(__linux__)
+   // The size of a symbol in this executable's symbol table. 0 if there is none, e.g. if stripped
+   size_t symbolSize(const std::string& name) {
+      std::ifstream exe("/proc/self/exe", std::ios::binary);
+      const std::vector<char> image((std::istreambuf_iterator<char>(exe)), std::istreambuf_iterator<char>());
+      if (image.size() < sizeof(Elf64_Ehdr) || image[EI_CLASS] != ELFCLASS64) {
+         return 0;
+      }
+      const auto header = reinterpret_cast<const Elf64_Ehdr*>(image.data());
+      const auto sections = reinterpret_cast<const Elf64_Shdr*>(image.data() + header->e_shoff);
+      for (size_t i = 0; i < header->e_shnum; ++i) {
+         if (sections[i].sh_type != SHT_SYMTAB) {
+            continue;
+         }
+         const char* names = image.data() + sections[sections[i].sh_link].sh_offset;
+         const auto symbols = reinterpret_cast<const Elf64_Sym*>(image.data() + sections[i].sh_offset);
+         for (size_t s = 0; s < sections[i].sh_size / sizeof(Elf64_Sym); ++s) {
+            if (name == names + symbols[s].st_name) {
+               return symbols[s].st_size;
+            }
+         }
+      }
+      return 0;
+   }
+#endif
+} // anonymous
+
+
+#define G3_BENCH_STEP(n) x = (x ^ (x >> 29)) * (0x9e3779b97f4a7c15ULL + n);
+#define G3_BENCH_LOGGED_STEP(n) G3_BENCH_STEP(n) LOG_IF(INFO, g_log_it) << "step " << n << ": " << x;
+
+#define G3_BENCH_8_STEPS(STEP, n) STEP(n) STEP(n + 1) STEP(n + 2) STEP(n + 3) STEP(n + 4) STEP(n + 5) STEP(n + 6) STEP(n + 7)
+#define G3_BENCH_32_STEPS(STEP) G3_BENCH_8_STEPS(STEP, 0) G3_BENCH_8_STEPS(STEP, 8) G3_BENCH_8_STEPS(STEP, 16) G3_BENCH_8_STEPS(STEP, 24)
+
+// extern "C": the symbol names are not mangled, so they are easy to find in the symbol table
+extern "C" G3_NOINLINE uint64_t g3_bench_plain_loop(uint64_t iterations) {
+   uint64_t x = iterations;
+   for (uint64_t i = 0; i < iterations; ++i) {
+      G3_BENCH_32_STEPS(G3_BENCH_STEP)
+   }
+   return x;
+}
+
+extern "C" G3_NOINLINE uint64_t g3_bench_logged_loop(uint64_t iterations) {
+   uint64_t x = iterations;
+   for (uint64_t i = 0; i < iterations; ++i) {
+      G3_BENCH_32_STEPS(G3_BENCH_LOGGED_STEP)
+   }
+   return x;
+}
+
+
+int main(int argc, char** argv) {
+   uint64_t iterations = 10000000;
+   if (argc == 2) {
+      iterations = std::strtoull(argv[1], nullptr, 10);
+   }
+   if (argc > 2 || iterations == 0) {
+      std::cerr << "USAGE is: " << argv[0] << " [number_of_iterations]" << std::endl;
+      return 1;
+   }
+
+   // No logger is initialized: no LOG_IF call is taken, only the not taken calls are measured
+   uint64_t checksum = 0;
+   const double plain_ns = nanosecondsPerIteration(g3_bench_plain_loop, iterations, checksum);
+   const double logged_ns = nanosecondsPerIteration(g3_bench_logged_loop, iterations, checksum);
+
+   std::cout << "32 arithmetic steps per iteration, best of 5 runs of " << iterations << " iterations\n"
+             << std::fixed << std::setprecision(2)
+             << "without LOG_IF:         " << std::setw(8) << plain_ns << " ns/iteration\n"
+             << "with 32 LOG_IF, false:  " << std::setw(8) << logged_ns << " ns/iteration, "
+             << (logged_ns - plain_ns) / 32 * 1000 << " ps per LOG_IF\n";
+#if defined(__linux__)
+   const size_t plain_size = symbolSize("g3_bench_plain_loop");
+   const size_t hot_size = symbolSize("g3_bench_logged_loop");
+   const size_t cold_size = symbolSize("g3_bench_logged_loop.cold");
+   std::cout << "code size, bytes:       without LOG_IF " << plain_size << ", with LOG_IF " << hot_size
+             << " (+" << (hot_size > plain_size ? hot_size - plain_size : 0) << ") in the loop and "
+             << cold_size << " in its cold part\n";
+#endif
+   std::cout << "(checksum " << checksum << ")" << std::endl;
+   return 0;
+}
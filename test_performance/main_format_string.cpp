@@ -0,0 +1,115 @@
+/** ==========================================================================
+* 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+* with no warranties. This code is yours to share, use and modify with no
+* strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+* ============================================================================*/
+
+// Compares the two LOGF formatting engines, see G3_LOGF_BACKEND in Options.cmake:
+// the C library's snprintf and g3log's tz_snprintf, for integer, string, floating
+// point and mixed workloads. No logging is done, only the formatting is timed.
+#include "g3log/format_string.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+   const char* const kNames[] = {"alpha", "a much longer user name", "", "x", "beta-gamma-delta"};
+
+   // the same formatting, done by one of the engines
+   template <typename Format>
+   int integers(Format format, char* buffer, size_t size, size_t i) {
+      return format(buffer, size, "%d %5u %08x %lld %-6i|%zu", static_cast<int>(i) - 5000, static_cast<unsigned>(i * 7),
+                    static_cast<unsigned>(i * 2654435761u), static_cast<long long>(i) * 1000003LL, static_cast<int>(i % 100), i);
+   }
+
+   template <typename Format>
+   int strings(Format format, char* buffer, size_t size, size_t i) {
+      const char* name = kNames[i % 5];
+      return format(buffer, size, "%s: %-12s [%.5s] %20s", name, kNames[(i + 1) % 5], name, kNames[(i + 2) % 5]);
+   }
+
+   template <typename Format>
+   int floatingPoint(Format format, char* buffer, size_t size, size_t i) {
+      const double value = static_cast<double>(i) * 1.0001 - 1234.5;
+      return format(buffer, size, "%f %.3e %10.4g %.17g", value, value * 1e-7, value / 3, 1.0 / (static_cast<double>(i) + 1));
+   }
+
+   template <typename Format>
+   int mixed(Format format, char* buffer, size_t size, size_t i) {
+      return format(buffer, size, "user %s logged in from %d.%d.%d.%d after %.2f ms (%zu tries)", kNames[i % 5],
+                    static_cast<int>(i & 255), 10, 0, static_cast<int>((i >> 8) & 255), static_cast<double>(i % 1000) / 7, i % 3);
+   }
+
+   struct Libc {
+      template <typename... Args>
+      int operator()(char* buffer, size_t size, const char* format, Args... args) const {
+         return std::snprintf(buffer, size, format, args...);
+      }
+   };
+
+   struct Tz {
+      template <typename... Args>
+      int operator()(char* buffer, size_t size, const char* format, Args... args) const {
+         return tz_snprintf(buffer, size, format, args...);
+      }
+   };
+
+   // nanoseconds per call. The returned lengths are summed so that no call can be left out
+   template <typename Workload>
+   double measure(Workload workload, size_t iterations, uint64_t& checksum) {
+      char buffer[512];
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < iterations; ++i) {
+         checksum += static_cast<uint64_t>(workload(buffer, sizeof(buffer), i));
+      }
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / static_cast<double>(iterations);
+   }
+
+   template <typename LibcWorkload, typename TzWorkload>
+   void compare(const std::string& name, LibcWorkload libc, TzWorkload tz, size_t iterations) {
+      uint64_t libc_checksum = 0;
+      uint64_t tz_checksum = 0;
+      const double libc_ns = measure(libc, iterations, libc_checksum);
+      const double tz_ns = measure(tz, iterations, tz_checksum);
+      std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+                << std::setw(10) << libc_ns << std::setw(10) << tz_ns
+                << std::setw(9) << std::setprecision(2) << (libc_ns / tz_ns) << "x"
+                << ((libc_checksum == tz_checksum) ? "" : "   (the output lengths differ)") << std::endl;
+   }
+} // anonymous
+
+
+int main(int argc, char** argv) {
+   size_t iterations = 1000000;
+   if (argc == 2) {
+      iterations = static_cast<size_t>(std::strtoull(argv[1], nullptr, 10));
+   }
+   if (argc > 2 || iterations == 0) {
+      std::cerr << "USAGE is: " << argv[0] << " [number_of_iterations]" << std::endl;
+      return 1;
+   }
+
+   std::cout << "snprintf vs tz_snprintf, " << iterations << " calls per workload\n";
+   std::cout << std::left << std::setw(16) << "workload" << std::right << std::setw(10) << "libc ns"
+             << std::setw(10) << "tz ns" << std::setw(10) << "speedup" << std::endl;
+
+   const Libc libc;
+   const Tz tz;
+   compare("integers", [&](char* b, size_t s, size_t i) { return integers(libc, b, s, i); },
+                       [&](char* b, size_t s, size_t i) { return integers(tz, b, s, i); }, iterations);
+   compare("strings", [&](char* b, size_t s, size_t i) { return strings(libc, b, s, i); },
+                      [&](char* b, size_t s, size_t i) { return strings(tz, b, s, i); }, iterations);
+   compare("floating point", [&](char* b, size_t s, size_t i) { return floatingPoint(libc, b, s, i); },
+                             [&](char* b, size_t s, size_t i) { return floatingPoint(tz, b, s, i); }, iterations);
+   compare("mixed", [&](char* b, size_t s, size_t i) { return mixed(libc, b, s, i); },
+                    [&](char* b, size_t s, size_t i) { return mixed(tz, b, s, i); }, iterations);
+   return 0;
+}
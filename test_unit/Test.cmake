@@ -95,6 +95,7 @@
             test_sink
             test_rotate_sink
             test_filter_sink
+            test_format_string
             ${OS_SPECIFIC_TEST}
         )
      SET(helper ${DIR_UNIT_TEST}/testing_helpers.h ${DIR_UNIT_TEST}/testing_helpers.cpp)
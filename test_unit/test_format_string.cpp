@@ -0,0 +1,224 @@
+/** ==========================================================================
+* 2013 by KjellKod.cc. This is PUBLIC DOMAIN to use at your own risk and comes
+* with no warranties. This code is yours to share, use and modify with no
+* strings attached and no restrictions or obligations.
+ *
+ * For more information see g3log/LICENSE or refer refer to http://unlicense.org
+* ============================================================================*/
+
+#include <gtest/gtest.h>
+#include <g3log/format_string.hpp>
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Differential test of tz_snprintf, the G3_LOG_TZ_VSNPRINTF formatting engine, against the
+// C library's snprintf. A corpus of format specifiers is generated from every combination of
+// flags, width, precision, length modifier and conversion, and each specifier is formatted
+// with a set of edge case values. The output and the return value must be identical.
+//
+// Left out, since the C standard leaves them undefined or implementation defined:
+// '#' with [cdisup], '0' with [csp], flags other than '-' with [csp], precision with [cp]
+// and %La (the leading hex digit of a long double is the implementation's choice)
+namespace {
+   using ssize_type = std::make_signed<size_t>::type;
+   using uptrdiff_type = std::make_unsigned<ptrdiff_t>::type;
+
+   const size_t kBufferSize = 2048;
+
+   struct Corpus {
+      size_t compared = 0;
+      size_t mismatches = 0;
+
+      template <typename... Args>
+      void compare(const std::string& format, Args... args) {
+         char expected[kBufferSize];
+         char actual[kBufferSize];
+         const int expected_return = std::snprintf(expected, sizeof(expected), format.c_str(), args...);
+         const int actual_return = tz_snprintf(actual, sizeof(actual), format.c_str(), args...);
+         ++compared;
+         if (expected_return == actual_return && 0 == std::strcmp(expected, actual)) {
+            return;
+         }
+         if (++mismatches <= 25) {
+            ADD_FAILURE() << "format \"" << format << "\"\n  libc: [" << expected << "] " << expected_return
+                          << "\n  tz:   [" << actual << "] " << actual_return;
+         }
+      }
+   };
+
+   const std::vector<std::string> kWidths = {"", "1", "7", "24"};
+
+   std::vector<std::string> allFlags() {
+      return {"", "-", "+", " ", "#", "0", "-+", "+0", " 0", "#0", "-#", "+ ", "-0"};
+   }
+
+   std::vector<std::string> withoutAlternateForm(const std::vector<std::string>& flags) {
+      std::vector<std::string> result;
+      for (auto& flag : flags) {
+         if (flag.find('#') == std::string::npos) {
+            result.push_back(flag);
+         }
+      }
+      return result;
+   }
+
+   std::string specifier(const std::string& flag, const std::string& width, const std::string& precision,
+                         const std::string& length, char conversion) {
+      return "%" + flag + width + precision + length + conversion;
+   }
+
+   // passes the value as the type the length modifier asks for
+   void compareInteger(Corpus& corpus, const std::string& format, const std::string& length, bool is_signed, long long value) {
+      if (length == "l") {
+         is_signed ? corpus.compare(format, static_cast<long>(value)) : corpus.compare(format, static_cast<unsigned long>(value));
+      } else if (length == "ll") {
+         is_signed ? corpus.compare(format, value) : corpus.compare(format, static_cast<unsigned long long>(value));
+      } else if (length == "j") {
+         is_signed ? corpus.compare(format, static_cast<intmax_t>(value)) : corpus.compare(format, static_cast<uintmax_t>(value));
+      } else if (length == "z") {
+         is_signed ? corpus.compare(format, static_cast<ssize_type>(value)) : corpus.compare(format, static_cast<size_t>(value));
+      } else if (length == "t") {
+         is_signed ? corpus.compare(format, static_cast<ptrdiff_t>(value)) : corpus.compare(format, static_cast<uptrdiff_type>(value));
+      } else { // "", "h" and "hh" all take an int
+         is_signed ? corpus.compare(format, static_cast<int>(value)) : corpus.compare(format, static_cast<unsigned int>(value));
+      }
+   }
+} // anonymous
+
+
+TEST(FormatString, IntegersMatchLibc) {
+   const std::vector<long long> values = {0, 1, -1, 7, -42, 127, -128, 255, 256, 32767, -32768, 65535,
+                                          0x1234abcd, INT_MAX, INT_MIN, UINT_MAX, LLONG_MAX, LLONG_MIN
+                                         };
+   const std::vector<std::string> lengths = {"hh", "h", "", "l", "ll", "j", "z", "t"};
+   const std::vector<std::string> precisions = {"", ".", ".0", ".1", ".4", ".17"};
+   const std::string conversions = "diuoxX";
+
+   Corpus corpus;
+   for (char conversion : conversions) {
+      const bool is_signed = (conversion == 'd' || conversion == 'i');
+      const auto flags = (conversion == 'o' || conversion == 'x' || conversion == 'X') ? allFlags() : withoutAlternateForm(allFlags());
+      for (auto& flag : flags) {
+         for (auto& width : kWidths) {
+            for (auto& precision : precisions) {
+               for (auto& length : lengths) {
+                  const auto format = specifier(flag, width, precision, length, conversion);
+                  for (auto value : values) {
+                     compareInteger(corpus, format, length, is_signed, value);
+                  }
+               }
+            }
+         }
+      }
+   }
+   EXPECT_EQ(0u, corpus.mismatches) << corpus.mismatches << " of " << corpus.compared << " differ";
+   EXPECT_GT(corpus.compared, 100000u);
+}
+
+
+TEST(FormatString, FloatingPointMatchesLibc) {
+   const std::vector<double> values = {0.0, -0.0, 1.0, -1.5, 0.5, 1.5, 2.5, 0.125, 3.14159265358979, -2.718281828459045,
+                                       1e-5, 0.0001, 123456.789, 999999.5, 1e15, 1e20, -1e100, 1e-300, DBL_MAX, DBL_MIN,
+                                       std::numeric_limits<double>::denorm_min(), 0.1, 9.9999, 0.00009995,
+                                       std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                                       std::numeric_limits<double>::quiet_NaN()
+                                      };
+   const std::vector<std::string> precisions = {"", ".", ".0", ".1", ".3", ".17", ".40"};
+   const std::string conversions = "fFeEgGaA";
+
+   Corpus corpus;
+   for (char conversion : conversions) {
+      for (auto& flag : allFlags()) {
+         for (auto& width : kWidths) {
+            for (auto& precision : precisions) {
+               const auto format = specifier(flag, width, precision, "", conversion);
+               const auto long_format = specifier(flag, width, precision, "L", conversion);
+               for (auto value : values) {
+                  const bool alternate_g = (flag.find('#') != std::string::npos) && (conversion == 'g' || conversion == 'G');
+                  if (alternate_g && value == 999999.5) {
+                     continue; // glibc prints "1.e+06" for %#g, dropping the zeros '#' should keep
+                  }
+                  corpus.compare(format, value);
+                  if (conversion != 'a' && conversion != 'A') {
+                     corpus.compare(long_format, static_cast<long double>(value));
+                  }
+               }
+            }
+         }
+      }
+   }
+   EXPECT_EQ(0u, corpus.mismatches) << corpus.mismatches << " of " << corpus.compared << " differ";
+   EXPECT_GT(corpus.compared, 100000u);
+}
+
+
+TEST(FormatString, CharactersStringsAndPointersMatchLibc) {
+   const std::vector<std::string> flags = {"", "-"};
+   const std::vector<std::string> precisions = {"", ".", ".0", ".1", ".5", ".30"};
+   const std::vector<const char*> strings = {"", "x", "hello", "a somewhat longer string value"};
+   const std::vector<int> characters = {'a', 'Z', ' ', '%', '0'};
+   int local = 0;
+   std::vector<void*> pointers = {&local, reinterpret_cast<void*>(0x1), reinterpret_cast<void*>(UINTPTR_MAX)};
+#if defined(__GLIBC__)
+   pointers.push_back(nullptr); // "(nil)" is glibc's way of showing it
+#endif
+
+   Corpus corpus;
+   for (auto& flag : flags) {
+      for (auto& width : kWidths) {
+         for (auto& precision : precisions) {
+            for (auto text : strings) {
+               corpus.compare(specifier(flag, width, precision, "", 's'), text);
+            }
+         }
+         for (auto c : characters) {
+            corpus.compare(specifier(flag, width, "", "", 'c'), c);
+         }
+         for (auto pointer : pointers) {
+            corpus.compare(specifier(flag, width, "", "", 'p'), pointer);
+         }
+      }
+   }
+   corpus.compare("100%% sure, %d%%", 42);
+   corpus.compare("%s=%d (%5.2f%%) [%-8s|%08.3e] %c%c %#x", "name", -17, 99.5, "left", -0.000123, 'o', 'k', 255u);
+   corpus.compare("%*d|%-*d|%.*f|%*.*s|", 6, 42, 6, 42, 2, 3.14159, 8, 3, "abcdef");
+   corpus.compare("%*d|%.*d|", -6, 42, -1, 42); // negative width left adjusts, negative precision is ignored
+   corpus.compare("%zu %td %jd %hhu %hd", sizeof(corpus), ptrdiff_t{-3}, intmax_t{INT64_MIN}, 300, 70000);
+   EXPECT_EQ(0u, corpus.mismatches) << corpus.mismatches << " of " << corpus.compared << " differ";
+}
+
+
+TEST(FormatString, TruncatesLikeLibc) {
+   const char* format = "%s-%08.3f-%x";
+   for (size_t size : {0, 1, 2, 5, 12, 40}) {
+      char expected[64] = "untouched";
+      char actual[64] = "untouched";
+      const int expected_return = std::snprintf(expected, size, format, "truncate", -3.25, 0xbeefu);
+      const int actual_return = tz_snprintf(actual, size, format, "truncate", -3.25, 0xbeefu);
+      EXPECT_EQ(expected_return, actual_return) << "size " << size;
+      EXPECT_STREQ(expected, actual) << "size " << size;
+   }
+}
+
+
+TEST(FormatString, CountsWrittenCharacters) {
+   int count = 0;
+   signed char small = 0;
+   long long big = 0;
+   char buffer[64];
+   tz_snprintf(buffer, sizeof(buffer), "abc%n%5d%hhn|%lln", &count, 42, &small, &big);
+   EXPECT_STREQ("abc   42|", buffer);
+   EXPECT_EQ(3, count);
+   EXPECT_EQ(8, small);
+   EXPECT_EQ(9, big);
+}
@@ -12,6 +12,8 @@
 #include "testing_helpers.h"
 #include "g3log/loglevels.hpp"
 #include "g3log/generated_definitions.hpp"
+#include "g3log/logstaging.hpp"
+#include "g3log/logpreinit.hpp"
 
 #include <memory>
 #include <string>
@@ -20,6 +22,12 @@
 #include <chrono>
 #include <exception>
 #include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <atomic>
 
 namespace {
    const std::string log_directory = "./";
@@ -68,10 +76,10 @@ TEST(Initialization, No_Logger_Initialized___Expecting_LOG_calls_to_be_Still_OKi
    EXPECT_TRUE(g3::logLevel(G3LOG_DEBUG));
    EXPECT_TRUE(g3::logLevel(WARNING));
    std::string err_msg1 = "Hey. I am not instantiated but I still should not crash. (I am g3log)";
-   std::string err_msg3_ignored = "This uninitialized message should be ignored";
+   std::string err_msg2 = "This uninitialized message is also kept";
    try {
-      LOG(INFO) << err_msg1; // nothing happened. level not ON
-      LOG(INFO) << err_msg3_ignored; // nothing happened. level not ON
+      LOG(INFO) << err_msg1; // kept until the logger is initialized
+      LOG(INFO) << err_msg2;
 
    } catch (std::exception& e) {
       ADD_FAILURE() << "Should never have thrown even if it is not instantiated. Ignored exception:  " << e.what();
@@ -79,12 +87,14 @@ TEST(Initialization, No_Logger_Initialized___Expecting_LOG_calls_to_be_Still_OKi
 
    RestoreFileLogger logger(log_directory); // now instantiate the logger
 
-   std::string good_msg1 = "This message could have pulled in the uninitialized_call message";
+   std::string good_msg1 = "This message comes after the uninitialized messages";
    LOG(INFO) << good_msg1;
    auto content = logger.resetAndRetrieveContent(); // this synchronizes with the LOG(INFO) call if debug level would be ON.
    ASSERT_TRUE(verifyContent(content, err_msg1)) << "Content: [" << content << "]";
-   ASSERT_FALSE(verifyContent(content, err_msg3_ignored)) << "Content: [" << content << "]";
+   ASSERT_TRUE(verifyContent(content, err_msg2)) << "Content: [" << content << "]";
    ASSERT_TRUE(verifyContent(content, good_msg1)) << "Content: [" << content << "]";
+   EXPECT_LT(content.find(err_msg1), content.find(err_msg2));
+   EXPECT_LT(content.find(err_msg2), content.find(good_msg1));
 }
 #else
 TEST(Initialization, No_Logger_Initialized___Expecting_LOG_calls_to_be_Still_OKish) {
@@ -94,12 +104,11 @@ TEST(Initialization, No_Logger_Initialized___Expecting_LOG_calls_to_be_Still_OKi
    EXPECT_TRUE(g3::logLevel(G3LOG_DEBUG));
    EXPECT_TRUE(g3::logLevel(WARNING));
    std::string err_msg1 = "Hey. I am not instantiated but I still should not crash. (I am g3log)";
-   std::string err_msg3_ignored = "This uninitialized message should be ignored";
+   std::string err_msg2 = "This uninitialized message is also kept";
 
    try {
-      LOG(INFO) << err_msg1; // For the uninitialized logworker, arise a std::cerr << str << std::endl
-                             // while the first LOG msg is encountered.
-      LOG(INFO) << err_msg3_ignored;
+      LOG(INFO) << err_msg1; // kept until the logger is initialized, see g3log/logpreinit.hpp
+      LOG(INFO) << err_msg2;
 
    } catch (std::exception& e) {
       ADD_FAILURE() << "Should never have thrown even if it is not instantiated: " << e.what();
@@ -107,15 +116,87 @@ TEST(Initialization, No_Logger_Initialized___Expecting_LOG_calls_to_be_Still_OKi
 
    RestoreFileLogger logger(log_directory); // now instantiate the logger
 
-   std::string good_msg1 = "This message will pull in also the uninitialized_call message";
+   std::string good_msg1 = "This message comes after the uninitialized messages";
    LOG(INFO) << good_msg1;
    auto content = logger.resetAndRetrieveContent(); // this synchronizes with the LOG(INFO) call.
    ASSERT_TRUE(verifyContent(content, err_msg1)) << "Content: [" << content << "]";
-   ASSERT_FALSE(verifyContent(content, err_msg3_ignored)) << "Content: [" << content << "]";
+   ASSERT_TRUE(verifyContent(content, err_msg2)) << "Content: [" << content << "]";
    ASSERT_TRUE(verifyContent(content, good_msg1)) << "Content: [" << content << "]";
+   EXPECT_LT(content.find(err_msg1), content.find(err_msg2));
+   EXPECT_LT(content.find(err_msg2), content.find(good_msg1));
 }
 #endif // #ifdef G3_DYNAMIC_LOGGING
 
+TEST(Initialization, PreInit_FullRingDropsTheOldest) {
+   ASSERT_FALSE(g3::internal::isLoggingInitialized());
+   g3::internal::restartPreInitKeeping();
+   const size_t kLogged = g3::internal::kPreInitMessages + 3;
+   for (size_t index = 0; index < kLogged; ++index) {
+      LOG(INFO) << "pre-init #" << index << "#";
+   }
+
+   RestoreFileLogger logger(log_directory);
+   auto content = logger.resetAndRetrieveContent();
+   EXPECT_FALSE(verifyContent(content, "pre-init #0#")) << "Content: [" << content << "]";
+   EXPECT_FALSE(verifyContent(content, "pre-init #2#"));
+   EXPECT_TRUE(verifyContent(content, "pre-init #3#"));
+   const std::string newest = "pre-init #" + std::to_string(kLogged - 1) + "#";
+   EXPECT_TRUE(verifyContent(content, newest));
+   EXPECT_LT(content.find("pre-init #3#"), content.find(newest));
+
+   // the batch starts with the count of what was dropped
+   const std::string dropped = "3 messages logged before g3::initializeLogging were dropped";
+   ASSERT_TRUE(verifyContent(content, dropped));
+   EXPECT_TRUE(verifyContent(content.substr(0, content.find(dropped)), WARNING.text));
+   EXPECT_LT(content.find(dropped), content.find("pre-init #3#"));
+}
+
+TEST(Initialization, PreInit_MessageOverTheByteLimitIsDropped) {
+   ASSERT_FALSE(g3::internal::isLoggingInitialized());
+   g3::internal::restartPreInitKeeping();
+   const std::string big(g3::internal::kPreInitBytes, 'b');
+   LOG(INFO) << "kept before the big one";
+   LOG(INFO) << big;
+   LOG(INFO) << "kept after the big one";
+
+   RestoreFileLogger logger(log_directory);
+   auto content = logger.resetAndRetrieveContent();
+   EXPECT_TRUE(verifyContent(content, "kept before the big one")) << "Content: [" << content << "]";
+   EXPECT_TRUE(verifyContent(content, "kept after the big one"));
+   EXPECT_FALSE(verifyContent(content, big));
+   EXPECT_TRUE(verifyContent(content, "1 messages logged before g3::initializeLogging were dropped"));
+}
+
+TEST(Initialization, PreInit_WrittenToStderrOnAFatalEventBeforeInitialization) {
+   ASSERT_FALSE(g3::internal::isLoggingInitialized());
+   g3::internal::restartPreInitKeeping();
+   LOG(INFO) << "kept until the fatal event";
+
+#if GTEST_HAS_DEATH_TEST
+   // the real fatal handling, not the test's mock, in the child process of the death test
+   EXPECT_DEATH({
+      g3::setFatalExitHandler(&g3::internal::pushFatalMessageToLogger);
+      LOG(FATAL) << "fatal before the initialization";
+   },
+                "LOGGER NOT INITIALIZED.*kept until the fatal event.*FATAL CALL but logger is NOT initialized");
+#endif
+
+   // what the fatal event, or an exit, writes
+   std::ostringstream captured;
+   auto* cerr_buffer = std::cerr.rdbuf(captured.rdbuf());
+   g3::internal::dumpPreInitMessages();
+   std::cerr.rdbuf(cerr_buffer);
+   EXPECT_TRUE(verifyContent(captured.str(), "LOGGER NOT INITIALIZED")) << "Captured: [" << captured.str() << "]";
+   EXPECT_TRUE(verifyContent(captured.str(), "kept until the fatal event"));
+
+   // the keeping has ended, what is logged now is not kept
+   LOG(INFO) << "not kept after the dump";
+   RestoreFileLogger logger(log_directory);
+   auto content = logger.resetAndRetrieveContent();
+   EXPECT_FALSE(verifyContent(content, "not kept after the dump"));
+   EXPECT_FALSE(verifyContent(content, "kept until the fatal event"));
+}
+
 TEST(Basics, Levels_StdFind) {
    std::vector<LEVELS> levels = {INFO, WARNING, FATAL};
    auto info = INFO;
@@ -253,6 +334,216 @@ TEST(LogTest, LOG_F) {
 }
 
 
+TEST(LogTest, LOG_F_LongTextIsNotTruncated) {
+   const std::string prefix(3000, 'a');
+   const std::string suffix(6000, 'b');
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      LOGF(INFO, "%s %d %s", prefix.c_str(), 42, suffix.c_str());
+      LOGF(INFO, "short %s", "after long");
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+#ifdef G3_DYNAMIC_MAX_MESSAGE_SIZE
+   EXPECT_TRUE(verifyContent(file_content, "[...truncated...]"));
+#else
+   EXPECT_TRUE(verifyContent(file_content, prefix + " 42 " + suffix + "\n"));
+   EXPECT_FALSE(verifyContent(file_content, "[...truncated...]"));
+#endif
+   EXPECT_TRUE(verifyContent(file_content, "short after long"));
+}
+
+
+TEST(LogTest, LOG_FromManyThreadsKeepsTheOrderOfEachThread) {
+   const int kThreads = 4;
+   const int kLines = 300;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      std::vector<std::thread> threads;
+      for (int thread = 0; thread < kThreads; ++thread) {
+         threads.emplace_back([thread] {
+            for (int line = 0; line < kLines; ++line) {
+               LOG(INFO) << "thread " << thread << " line " << line << ";";
+            }
+         });
+      }
+      for (auto& thread : threads) {
+         thread.join();
+      }
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   for (int thread = 0; thread < kThreads; ++thread) {
+      size_t previous = 0;
+      for (int line = 0; line < kLines; ++line) {
+         const std::string text = "thread " + std::to_string(thread) + " line " + std::to_string(line) + ";";
+         const size_t position = file_content.find(text);
+         ASSERT_NE(std::string::npos, position) << text;
+         ASSERT_LE(previous, position) << text;
+         previous = position;
+      }
+   }
+}
+
+
+#ifdef G3_LOG_STAGING
+TEST(LogTest, LOG_StagedMessagesOfAQuietThreadAreWrittenWithoutShutdown) {
+   RestoreFileLogger logger(log_directory);
+   std::atomic<bool> done {false};
+   std::thread quiet([&done] {
+      LOG(INFO) << "staged and then quiet";
+      while (!done) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+   });
+
+   // below the count and byte thresholds: the LogWorker collects it after max_delay
+   bool written = false;
+   for (int wait = 0; wait < 2000 && !written; wait += 5) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      written = verifyContent(readFileToText(logger.logFile()), "staged and then quiet");
+   }
+   done = true;
+   quiet.join();
+   EXPECT_TRUE(written);
+   EXPECT_EQ(64u, g3::stagingThresholds().max_messages);
+}
+
+// the LogWorker thread collects the staging areas while the worker is destroyed: run with
+// -fsanitize=thread to see that neither that nor the logging threads race the shutdown
+TEST(LogTest, LOG_StagingLogWorkerDestroyedWhileThreadsLog) {
+   const int kThreads = 4;
+   std::atomic<bool> done {false};
+   std::atomic<int> logged {0};
+   std::string file_content;
+   std::vector<std::thread> threads;
+   {
+      RestoreFileLogger logger(log_directory);
+      for (int thread = 0; thread < kThreads; ++thread) {
+         threads.emplace_back([thread, &done, &logged] {
+            while (!done) {
+               LOG(INFO) << "thread " << thread << " logs during the shutdown";
+               ++logged;
+               if (0 == logged % 16) {
+                  std::this_thread::sleep_for(std::chrono::microseconds(100)); // some areas are left to the collection
+               }
+            }
+         });
+      }
+      while (logged < 1000) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      // destroys the LogWorker with a collection of the staging areas due every 10 ms
+      file_content = logger.resetAndRetrieveContent();
+      EXPECT_FALSE(g3::internal::isLoggingInitialized());
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   }
+   done = true;
+   for (auto& thread : threads) {
+      thread.join();
+   }
+   EXPECT_TRUE(verifyContent(file_content, "logs during the shutdown"));
+}
+
+TEST(LogTest, LOG_StagingCollectionOnlyAfterMessagesWereStaged) {
+   ASSERT_FALSE(g3::internal::isLoggingInitialized());
+   size_t batches = 0;
+   size_t messages = 0;
+   auto count = [&](g3::LogMessageBatch batch) {
+      ++batches;
+      messages += batch.get().size();
+   };
+   g3::internal::collectStagedMessages(count); // what earlier tests left
+   batches = messages = 0;
+
+   g3::internal::stageMessage(std::make_unique<g3::LogMessage>("file.cpp", 1, "function", INFO, "", "first",
+                                                               g3::LogMessage::Details::Copy));
+   g3::internal::stageMessage(std::make_unique<g3::LogMessage>("file.cpp", 2, "function", INFO, "", "second",
+                                                               g3::LogMessage::Details::Copy));
+   g3::internal::collectStagedMessages(count);
+   EXPECT_EQ(1u, batches);
+   EXPECT_EQ(2u, messages);
+
+   // nothing staged since: the idle areas are not swept
+   g3::internal::collectStagedMessages(count);
+   EXPECT_EQ(1u, batches);
+
+   g3::internal::stageMessage(std::make_unique<g3::LogMessage>("file.cpp", 3, "function", INFO, "", "third",
+                                                               g3::LogMessage::Details::Copy));
+   g3::internal::collectStagedMessages(count);
+   EXPECT_EQ(2u, batches);
+   EXPECT_EQ(3u, messages);
+}
+#endif
+
+
+// {}-type log
+namespace {
+   template<typename FormatString, typename... Args>
+   std::string formatted(FormatString, const Args&... args) {
+      auto stream = g3::internal::acquireLogStream();
+      g3::internal::formatTo<FormatString>(*stream, args...);
+      std::string text = stream->c_str();
+      g3::internal::releaseLogStream(stream);
+      return text;
+   }
+
+   struct Streamable {};
+   std::ostream& operator<<(std::ostream& os, const Streamable&) {
+      return os << "streamable";
+   }
+
+   // broken format strings are compilation errors, the parser is checked here
+   using g3::internal::FormatError;
+   static_assert(FormatError::None == g3::internal::parseFormat<2>("{} {{}} {:>8.3f}").error, "");
+   static_assert(FormatError::TooFewArguments == g3::internal::parseFormat<1>("{} {}").error, "");
+   static_assert(FormatError::TooManyArguments == g3::internal::parseFormat<2>("{}").error, "");
+   static_assert(FormatError::UnmatchedOpenBrace == g3::internal::parseFormat<1>("{ {}").error, "");
+   static_assert(FormatError::UnmatchedCloseBrace == g3::internal::parseFormat<0>("}").error, "");
+   static_assert(FormatError::ArgumentIndexNotSupported == g3::internal::parseFormat<1>("{0}").error, "");
+   static_assert(FormatError::InvalidSpec == g3::internal::parseFormat<1>("{:.}").error, "");
+   static_assert(FormatError::TypeMismatch == g3::internal::checkArguments<const char*>(g3::internal::parseFormat<1>("{:x}")), "");
+   static_assert(FormatError::PrecisionNotAllowed == g3::internal::checkArguments<int>(g3::internal::parseFormat<1>("{:.2}")), "");
+   static_assert(FormatError::FlagNotAllowed == g3::internal::checkArguments<std::string>(g3::internal::parseFormat<1>("{:+}")), "");
+}
+
+TEST(LogTest, LOGFMT_Formatting) {
+   EXPECT_EQ("no arguments {literal}", formatted(G3_FORMAT_STRING("no arguments {{literal}}")));
+   EXPECT_EQ("1977 650000 -5 18446744073709551615", formatted(G3_FORMAT_STRING("{} {} {} {}"), 1977, 650000L, static_cast<short>(-5),
+                                                               std::numeric_limits<unsigned long long>::max()));
+   EXPECT_EQ("-9223372036854775808", formatted(G3_FORMAT_STRING("{}"), std::numeric_limits<long long>::min()));
+   EXPECT_EQ("      1977|0000001977|-000001977|+1977", formatted(G3_FORMAT_STRING("{:10}|{:010}|{:010}|{:+}"), 1977, 1977, -1977, 1977));
+   EXPECT_EQ("100 64 144 0x64 0144 0X64 0b101", formatted(G3_FORMAT_STRING("{} {:x} {:o} {:#x} {:#o} {:#X} {:#b}"), 100, 100, 100, 100, 100, 100, 5));
+   EXPECT_EQ("0x00ff", formatted(G3_FORMAT_STRING("{:#06x}"), 255));
+   EXPECT_EQ("3.14 +3e+00 3.141600E+00 0.1 1e+300", formatted(G3_FORMAT_STRING("{:4.2f} {:+.0e} {:E} {} {}"), 3.1416, 3.1416, 3.1416, 0.1, 1e300));
+   EXPECT_EQ("inf -INF 0001.5", formatted(G3_FORMAT_STRING("{} {:F} {:06.1f}"), std::numeric_limits<double>::infinity(),
+                                          -std::numeric_limits<double>::infinity(), 1.5));
+   EXPECT_EQ("   right|left    |*center*|ab", formatted(G3_FORMAT_STRING("{:>8}|{:<8}|{:*^8}|{:.2}"), "right", "left", "center", std::string("abc")));
+   EXPECT_EQ("a 65 true false (null)", formatted(G3_FORMAT_STRING("{} {:d} {} {:s} {}"), 'a', 'A', true, false, static_cast<const char*>(nullptr)));
+   EXPECT_EQ("0x0 A", formatted(G3_FORMAT_STRING("{} {:c}"), nullptr, 65));
+   EXPECT_EQ("streamable  |  streamable", formatted(G3_FORMAT_STRING("{:<12}|{:>12}"), Streamable{}, Streamable{}));
+
+   // nothing is truncated
+   const std::string big(5000, 'x');
+   EXPECT_EQ(big + "!", formatted(G3_FORMAT_STRING("{}!"), big));
+}
+
+TEST(LogTest, LOGFMT) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      LOGFMT(INFO, "LOGFMT info {} {:.3f}", 123, 1.123456);
+      LOGFMT_IF(WARNING, 1 < 2, "LOGFMT_IF warning {:>5}", "yes");
+      LOGFMT_IF(WARNING, 1 > 2, "LOGFMT_IF {} should not be seen", "this");
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content, "LOGFMT info 123 1.123"));
+   EXPECT_TRUE(verifyContent(file_content, "LOGFMT_IF warning   yes"));
+   EXPECT_FALSE(verifyContent(file_content, "should not be seen"));
+}
 
 
 // stream-type log
@@ -272,6 +563,178 @@ TEST(LogTest, LOG) {
    ASSERT_TRUE(verifyContent(file_content, t_warning3));
 }
 
+TEST(LogTest, LogStream_SameOutputAsStdOstream) {
+   auto stream = g3::internal::acquireLogStream();
+   std::ostringstream expected;
+   const double kDoubles[] = {0.0, -0.0, 1.0, 1.5, 3.14159265358979, 1e-7, 123456789.0, 1e300, -2.5e-300};
+   for (auto d : kDoubles) {
+      *stream << d << " ";
+      expected << d << " ";
+   }
+   *stream << 1.123456f << " " << std::numeric_limits<long long>::min() << " " << std::numeric_limits<unsigned long long>::max()
+           << " " << 'c' << " " << std::string("str") << " " << true << " " << static_cast<short>(-7);
+   expected << 1.123456f << " " << std::numeric_limits<long long>::min() << " " << std::numeric_limits<unsigned long long>::max()
+            << " " << 'c' << " " << std::string("str") << " " << true << " " << static_cast<short>(-7);
+
+   // manipulators must be respected, the fast paths are then not used
+   *stream << " " << std::hex << 255 << std::dec << " " << std::setw(6) << 42 << " " << std::showpos << 3
+           << std::noshowpos << " " << std::fixed << std::setprecision(2) << 1.005 << " " << std::setw(5) << "ab";
+   expected << " " << std::hex << 255 << std::dec << " " << std::setw(6) << 42 << " " << std::showpos << 3
+            << std::noshowpos << " " << std::fixed << std::setprecision(2) << 1.005 << " " << std::setw(5) << "ab";
+   EXPECT_EQ(expected.str(), std::string(stream->c_str()));
+   g3::internal::releaseLogStream(stream);
+
+   // the next user of the stream gets a clean formatting state
+   stream = g3::internal::acquireLogStream();
+   *stream << 255 << " " << 0.5;
+   EXPECT_EQ(std::string("255 0.5"), std::string(stream->c_str()));
+   g3::internal::releaseLogStream(stream);
+}
+
+
+TEST(LogTest, LogStream_DeferredSameOutputAsEager) {
+   auto write = [](g3::LogStream& stream) {
+      stream << "text " << 42 << ' ' << -7L << " " << std::numeric_limits<unsigned long long>::max()
+             << " " << 3.14159265358979 << " " << 1.5f << std::string(" str ") << true
+             << " " << std::hex << 255 << std::dec << " " << std::setw(4) << 1 << std::endl
+             << std::setprecision(10) << 2.0 / 3 << " " << std::fixed << 0.25 << " end";
+   };
+   auto eager = g3::internal::acquireLogStream();
+   write(*eager);
+   const std::string expected = eager->c_str();
+   g3::internal::releaseLogStream(eager);
+
+   auto deferred = g3::internal::acquireLogStream();
+   deferred->setDeferred(true);
+   write(*deferred);
+   const std::string record {deferred->arguments()};
+   g3::internal::releaseLogStream(deferred);
+   EXPECT_EQ(std::string::npos, record.find("3.14159")) << "the double should not be formatted yet";
+
+   g3::MessageBuffer formatted;
+   g3::internal::formatArguments(record, formatted);
+   EXPECT_EQ(expected, formatted);
+
+   // a LogMessage formats the record when the text is asked for
+   g3::LogMessage message {"file.cpp", 1, "function", INFO, "", "", g3::LogMessage::Details::Copy};
+   message._arguments = record;
+   EXPECT_EQ(expected, message.message());
+   EXPECT_TRUE(message._arguments.empty());
+}
+
+
+TEST(LogTest, LogStream_HexDumpOfAllByteValues) {
+   unsigned char bytes[256];
+   std::string expected = "[256 bytes]";
+   for (size_t line = 0; line < 16; ++line) {
+      char text[128];
+      int length = snprintf(text, sizeof(text), "\n%08zx ", line * 16);
+      std::string ascii;
+      for (size_t index = 0; index < 16; ++index) {
+         const auto value = static_cast<unsigned char>(line * 16 + index);
+         bytes[line * 16 + index] = value;
+         length += snprintf(text + length, sizeof(text) - length, (8 == index) ? "  %02x" : " %02x", value);
+         ascii.push_back((value >= 0x20 && value < 0x7f) ? static_cast<char>(value) : '.');
+      }
+      expected.append(text).append("  |").append(ascii).append("|");
+   }
+
+   auto eager = g3::internal::acquireLogStream();
+   *eager << g3::hexdump(bytes, sizeof(bytes));
+   EXPECT_EQ(expected, std::string(eager->c_str()));
+   g3::internal::releaseLogStream(eager);
+
+   // deferred, the worker writes the same dump from the copied bytes
+   auto deferred = g3::internal::acquireLogStream();
+   deferred->setDeferred(true);
+   *deferred << "dump " << g3::hexdump(bytes, sizeof(bytes)) << " end";
+   const std::string record {deferred->arguments()};
+   g3::internal::releaseLogStream(deferred);
+   g3::MessageBuffer formatted;
+   g3::internal::formatArguments(record, formatted);
+   EXPECT_EQ("dump " + expected + " end", formatted);
+}
+
+
+TEST(LogTest, LOG_HEX_PartialLineAndLimit) {
+   const std::string text = "Hello, world\n";
+   std::vector<unsigned char> bytes(text.begin(), text.end());
+   for (unsigned char value = 0; value < 7; ++value) {
+      bytes.push_back(value);
+   }
+
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      LOG_HEX(INFO, bytes.data(), bytes.size());
+      LOG(INFO) << "first " << g3::hexdump(bytes.data(), bytes.size(), 4);
+      LOG_HEX(INFO, nullptr, 10);
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content,
+                             "[20 bytes]\n"
+                             "00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 0a 00 01 02  |Hello, world....|\n"
+                             "00000010  03 04 05 06                                       |....|\n")) << file_content;
+   EXPECT_TRUE(verifyContent(file_content, "first [4 of 20 bytes]\n"
+                             "00000000  48 65 6c 6c                                       |Hell|\n")) << file_content;
+   EXPECT_TRUE(verifyContent(file_content, "[0 of 10 bytes]\n")) << file_content;
+}
+
+
+TEST(LogTest, LOG_LAZY_CallableRunsOnTheWorker) {
+   std::atomic<int> calls {0};
+   std::thread::id rendered_by;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      std::vector<int> snapshot {1, 2, 3};
+      const std::string name = "table";
+      LOG_LAZY(INFO, [&calls, &rendered_by, snapshot = std::move(snapshot), name] {
+         ++calls;
+         rendered_by = std::this_thread::get_id();
+         return name + " of " + std::to_string(snapshot.size());
+      }) << "lazy: ";
+      LOG_LAZY(INFO, [] { return 1.5; });
+      LOG_LAZY(INFO, []() -> std::string { throw std::runtime_error("no render"); });
+#ifdef G3_DYNAMIC_LOGGING
+      {
+         g3::ScopedThreadLevel quiet(WARNING);
+         LOG_LAZY(INFO, [&calls] { ++calls; return "disabled"; });
+      }
+#endif
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(1, calls.load());
+   EXPECT_NE(std::this_thread::get_id(), rendered_by);
+   EXPECT_TRUE(verifyContent(file_content, "lazy: table of 3\n")) << file_content;
+   EXPECT_TRUE(verifyContent(file_content, "] 1.5\n")) << file_content;
+   EXPECT_TRUE(verifyContent(file_content, "[...LOG_LAZY exception: no render...]\n")) << file_content;
+   EXPECT_FALSE(verifyContent(file_content, "disabled")) << file_content;
+}
+
+
+namespace {
+   struct LogsWhileStreamed {};
+   std::ostream& operator<<(std::ostream& os, const LogsWhileStreamed&) {
+      LOG(INFO) << "nested LOG call from operator<<";
+      return os << "outer-part";
+   }
+}
+
+TEST(LogTest, LOG_NestedCallFromOperator) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      LOG(INFO) << "first-part " << LogsWhileStreamed{} << " last-part";
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content, "nested LOG call from operator<<")) << file_content;
+   EXPECT_TRUE(verifyContent(file_content, "first-part outer-part last-part")) << file_content;
+}
+
 TEST(LogTest, LOG_after_if) {
    std::string file_content;
    {
@@ -340,6 +803,261 @@ TEST(LogTest, LOG_IF) {
 }
 
 
+namespace {
+   size_t countOf(const std::string& text, const std::string& word) {
+      size_t count = 0;
+      for (size_t found = text.find(word); found != std::string::npos; found = text.find(word, found + 1)) {
+         ++count;
+      }
+      return count;
+   }
+} // anonymous
+
+TEST(LogTest, LOG_EVERY_N) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      for (int i = 0; i < 10; ++i) {
+         LOG_EVERY_N(INFO, 4) << "every fourth " << i << ";";
+      }
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(3u, countOf(file_content, "every fourth"));
+   EXPECT_TRUE(verifyContent(file_content, "every fourth 0;\n"));
+   EXPECT_TRUE(verifyContent(file_content, "every fourth 4; (suppressed 3 since last)"));
+   EXPECT_TRUE(verifyContent(file_content, "every fourth 8; (suppressed 3 since last)"));
+}
+
+TEST(LogTest, LOG_FIRST_N) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      for (int i = 0; i < 10; ++i) {
+         LOG_FIRST_N(INFO, 3) << "first three " << i;
+      }
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(3u, countOf(file_content, "first three"));
+   EXPECT_TRUE(verifyContent(file_content, "first three 2"));
+   EXPECT_FALSE(verifyContent(file_content, "first three 3"));
+}
+
+TEST(LogTest, LOG_EVERY_T) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      for (int i = 0; i < 3; ++i) {
+         for (int j = 0; j < 5; ++j) {
+            LOG_EVERY_T(INFO, 0.05) << "at most one per period " << i << "-" << j << ";";
+         }
+         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(3u, countOf(file_content, "at most one per period"));
+   EXPECT_TRUE(verifyContent(file_content, "at most one per period 0-0;"));
+   EXPECT_TRUE(verifyContent(file_content, "at most one per period 2-0; (suppressed 4 since last)"));
+}
+
+TEST(LogTest, LOG_EVERY_N_IF) {
+   std::string file_content;
+   size_t evaluated = 0;
+   {
+      RestoreFileLogger logger(log_directory);
+      for (int i = 0; i < 12; ++i) {
+         LOG_EVERY_N_IF(INFO, 2, (++evaluated, i % 3 == 0)) << "every other multiple of three " << i << ";";
+      }
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(12u, evaluated);
+   EXPECT_EQ(2u, countOf(file_content, "every other multiple of three"));
+   EXPECT_TRUE(verifyContent(file_content, "every other multiple of three 0;"));
+   EXPECT_TRUE(verifyContent(file_content, "every other multiple of three 6; (suppressed 1 since last)"));
+}
+
+TEST(LogTest, LOG_EVERY_N_FromManyThreads) {
+   const size_t kThreads = 4;
+   const size_t kMessagesPerThread = 1000;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < kThreads; ++t) {
+         threads.emplace_back([] {
+            for (size_t i = 0; i < kMessagesPerThread; ++i) {
+               LOG_EVERY_N(INFO, 100) << "shared call site";
+            }
+         });
+      }
+      for (auto& thread : threads) {
+         thread.join();
+      }
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(kThreads * kMessagesPerThread / 100, countOf(file_content, "shared call site"));
+   EXPECT_EQ(kThreads * kMessagesPerThread / 100 - 1, countOf(file_content, "(suppressed 99 since last)"));
+}
+
+TEST(LogTest, LOG_TypedFieldsAreWrittenAfterTheText) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      const std::string path = "/index.html";
+      LOG(INFO) << g3::kv("latency_us", 123) << g3::kv("path", path) << "request " << 7 << " done";
+      LOGF(INFO, "no fields %d", 1);
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content, "request 7 done latency_us=123 path=/index.html\n")) << file_content;
+   EXPECT_TRUE(verifyContent(file_content, "no fields 1\n")) << file_content;
+}
+
+TEST(LogTest, LOG_BelowTheMinimumLevelIsCompiledAway) {
+   using g3::internal::CompiledIn;
+   using g3::internal::LevelTag;
+   static_assert(CompiledIn<g3::internal::level_tags::Fatal>::value, "FATAL is always compiled");
+   static_assert(CompiledIn<LEVELS>::value, "a level only known at runtime is compiled");
+   static_assert(!CompiledIn<LevelTag<G3_LOG_MIN_LEVEL - 1, LEVELS>>::value, "");
+   static_assert(CompiledIn<LevelTag<G3_LOG_MIN_LEVEL, LEVELS>>::value, "");
+
+   const bool debug_compiled = (g3::kDebugValue >= G3_LOG_MIN_LEVEL);
+   const bool info_compiled = (g3::kInfoValue >= G3_LOG_MIN_LEVEL);
+   const bool warning_compiled = (g3::kWarningValue >= G3_LOG_MIN_LEVEL);
+   int debug_evaluated = 0;
+   int info_evaluated = 0;
+   int warning_evaluated = 0;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      LOG(G3LOG_DEBUG) << "debug call " << ++debug_evaluated;
+      LOGF(INFO, "info call %d", ++info_evaluated);
+      LOG_EVERY_N(WARNING, 1) << "warning call " << ++warning_evaluated;
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(debug_compiled ? 1 : 0, debug_evaluated);
+   EXPECT_EQ(info_compiled ? 1 : 0, info_evaluated);
+   EXPECT_EQ(warning_compiled ? 1 : 0, warning_evaluated);
+   EXPECT_EQ(debug_compiled, verifyContent(file_content, "debug call 1"));
+   EXPECT_EQ(info_compiled, verifyContent(file_content, "info call 1"));
+   EXPECT_EQ(warning_compiled, verifyContent(file_content, "warning call 1"));
+}
+
+TEST(LogTest, LOG_LevelChosenAtRuntime) {
+   // the built-in levels are all LEVELS, they can be mixed and assigned like any other level
+   auto level = INFO;
+   level = WARNING;
+   static_assert(std::is_same<decltype(level), LEVELS>::value, "");
+   const bool ok = level.value < FATAL.value;
+   const LEVELS custom {g3::kDebugValue + 1, "CUSTOM"};
+#ifdef G3_DYNAMIC_LOGGING
+   g3::only_change_at_initialization::addLogLevel(custom, true);
+#endif
+   // a conditional level is compiled in if the highest level it can be is
+   using g3::internal::CompiledIn;
+   using Conditional = std::decay_t<decltype(true ? g3::internal::level_tags::INFO : g3::internal::level_tags::WARNING)>;
+   static_assert(g3::kWarningValue == Conditional::kValue, "");
+   const bool warning_compiled = CompiledIn<Conditional>::value;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      LOG(ok ? WARNING : INFO) << "conditional level";
+      LOG(ok ? custom : INFO) << "conditional custom level";
+      LOG(level) << "assigned level";
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_EQ(warning_compiled, verifyContent(file_content, "conditional level"));
+   EXPECT_TRUE(verifyContent(file_content, "conditional custom level"));
+   EXPECT_TRUE(verifyContent(file_content, "assigned level"));
+#ifdef G3_DYNAMIC_LOGGING
+   g3::only_change_at_initialization::reset();
+#endif
+}
+
+TEST(LogTest, DLOG_OnlyWithoutNDEBUG) {
+   int evaluated = 0;
+   auto count = [&] { return ++evaluated; };
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      DLOG(INFO) << "debug only " << count();
+      DLOG_IF(INFO, count() > 0) << "debug only if";
+      DLOGF(INFO, "debug only printf %d", count());
+      DCHECK(count() > 0) << "not broken";
+      DCHECK_EQ(count(), evaluated);
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_FALSE(mockFatalWasCalled());
+#if defined(NDEBUG)
+   EXPECT_EQ(0, evaluated);
+   EXPECT_FALSE(verifyContent(file_content, "debug only"));
+#else
+   EXPECT_EQ(5, evaluated);
+   EXPECT_TRUE(verifyContent(file_content, "debug only 1"));
+   EXPECT_TRUE(verifyContent(file_content, "debug only if"));
+   EXPECT_TRUE(verifyContent(file_content, "debug only printf 3"));
+#endif
+}
+
+#ifdef G3_LOG_VMODULE
+namespace {
+   struct RestoreVModule {
+      ~RestoreVModule() {
+         g3::setVModule("");
+      }
+   };
+} // anonymous
+
+TEST(LogTest, VModule_RuleOfThisFileDecides) {
+   RestoreVModule restore;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      auto logBoth = [](const std::string& when) {
+         LOG(INFO) << "info " << when;
+         LOG(WARNING) << "warning " << when;
+      };
+      logBoth("without rules;");
+      ASSERT_TRUE(g3::setVModule("other.cpp=FATAL, test_unit/test_io.cpp=WARNING"));
+      logBoth("with a rule;");
+      ASSERT_TRUE(g3::setVModule("unit/test_io.cpp=FATAL,test_*.cpp=DEBUG"));
+      logBoth("not from the start of a name;");
+      ASSERT_TRUE(g3::setVModule(""));
+      logBoth("rules removed;");
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content, "info without rules;"));
+   EXPECT_FALSE(verifyContent(file_content, "info with a rule;"));
+   EXPECT_TRUE(verifyContent(file_content, "warning with a rule;"));
+   EXPECT_TRUE(verifyContent(file_content, "info not from the start of a name;"));
+   EXPECT_TRUE(verifyContent(file_content, "info rules removed;"));
+}
+
+TEST(LogTest, VModule_InvalidRulesAreNotUsed) {
+   RestoreVModule restore;
+   std::string error;
+   ASSERT_TRUE(g3::setVModule("net/*=DEBUG, storage/compaction.cpp = info, x?.cpp=1234"));
+   EXPECT_EQ("net/*=DEBUG, storage/compaction.cpp = info, x?.cpp=1234", g3::vModule());
+
+   EXPECT_FALSE(g3::setVModule("net/*", &error));
+   EXPECT_TRUE(verifyContent(error, "missing '='")) << error;
+   EXPECT_FALSE(g3::setVModule("=INFO", &error));
+   EXPECT_TRUE(verifyContent(error, "missing file pattern")) << error;
+   EXPECT_FALSE(g3::setVModule("net/*=LOUD", &error));
+   EXPECT_TRUE(verifyContent(error, "unknown level \"LOUD\"")) << error;
+   EXPECT_EQ("net/*=DEBUG, storage/compaction.cpp = info, x?.cpp=1234", g3::vModule());
+}
+
+#endif // G3_LOG_VMODULE
+
 TEST(LogTest, LOGF__FATAL) {
    RestoreFileLogger logger(log_directory);
    ASSERT_FALSE(mockFatalWasCalled());
@@ -591,6 +1309,17 @@ TEST(CHECK_F_Test, CHECK_F__thisWILL_PrintErrorMsg) {
 }
 
 
+TEST(CHECK_Test, CHECKFMT__thisWILL_PrintErrorMsg) {
+   RestoreFileLogger logger(log_directory);
+   CHECKFMT(1 >= 2, "This message is added to throw {} and {}", "message", 2);
+   logger.reset();
+   std::string file_content = readFileToText(logger.logFile());
+   EXPECT_TRUE(verifyContent(mockFatalMessage(), "EXIT trigger caused by "));
+   EXPECT_TRUE(verifyContent(file_content, "CONTRACT"));
+   EXPECT_TRUE(verifyContent(file_content, "This message is added to throw message and 2"));
+}
+
+
 TEST(CHECK_Test, CHECK__thisWILL_PrintErrorMsg) {
    RestoreFileLogger logger(log_directory);
    std::string msg = "This message is added to throw message and log";
@@ -616,6 +1345,98 @@ TEST(CHECK, CHECK_ThatWontThrow) {
    EXPECT_FALSE(verifyContent(mockFatalMessage(), msg3));
 }
 
+TEST(CHECK_Test, CHECK_EQ__thisWILL_PrintTheValues) {
+   RestoreFileLogger logger(log_directory);
+   int evaluated = 0;
+   auto three = [&] { ++evaluated; return 3; };
+   const int seven = 7;
+   CHECK_EQ(three(), seven) << "the values differ";
+
+   logger.reset();
+   std::string file_content = readFileToText(logger.logFile());
+   EXPECT_EQ(1, evaluated);
+   EXPECT_TRUE(verifyContent(mockFatalMessage(), "CHECK(three() == seven)"));
+   EXPECT_TRUE(verifyContent(file_content, "(3 vs 7) the values differ"));
+}
+
+TEST(CHECK_Test, CHECK_OP__thisWILL_PrintErrorMsg) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      const std::string name = "g3log";
+      CHECK_NE(name, std::string("g3log"));
+      CHECK_LT(2.5, 1);
+      CHECK_LE(10u, 9u);
+      CHECK_GT('a', 'b');
+      CHECK_EQ(nullptr, static_cast<const void*>(&name)) << "pointer";
+      logger.reset();
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content, "(g3log vs g3log)"));
+   EXPECT_TRUE(verifyContent(file_content, "(2.5 vs 1)"));
+   EXPECT_TRUE(verifyContent(file_content, "(10 vs 9)"));
+   EXPECT_TRUE(verifyContent(file_content, "('a' (97) vs 'b' (98))"));
+   EXPECT_TRUE(verifyContent(file_content, "(nullptr vs 0x"));
+}
+
+TEST(CHECK_Test, CHECK_OP__MixedSignednessIsComparedByValue) {
+   static_assert(g3::internal::cmpLess(-1, 0u), "");
+   static_assert(!g3::internal::cmpEqual(-1, static_cast<unsigned>(-1)), "");
+   static_assert(g3::internal::cmpEqual(size_t{3}, 3), "");
+   static_assert(!g3::internal::cmpLess(size_t{0}, -1), "");
+
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      const std::vector<int> values = {1, 2, 3};
+      const int minus_one = -1;
+      CHECK_EQ(values.size(), 3) << "should never appear";
+      CHECK_LT(values[0], 2u) << "should never appear";
+      CHECK_LT(minus_one, values.size()) << "should never appear";
+      CHECK_GE(values.size(), minus_one) << "should never appear";
+      CHECK_NE(minus_one, static_cast<unsigned>(-1)) << "should never appear";
+      CHECK_LE(values.size(), 2) << "too many";
+      logger.reset();
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_FALSE(verifyContent(file_content, "should never appear"));
+   EXPECT_TRUE(verifyContent(file_content, "(3 vs 2) too many"));
+}
+
+TEST(CHECK_Test, CHECK_OP__NullCStringIsPrintedAsNullptr) {
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      const char* missing = nullptr;
+      const char* name = "g3log";
+      char* also_missing = nullptr;
+      CHECK_EQ(missing, name) << "first";
+      CHECK_NE(also_missing, static_cast<char*>(nullptr)) << "second";
+      logger.reset();
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content, "(nullptr vs g3log) first"));
+   EXPECT_TRUE(verifyContent(file_content, "(nullptr vs nullptr) second"));
+}
+
+TEST(CHECK, CHECK_OP_ThatWontThrow) {
+   RestoreFileLogger logger(log_directory);
+   int evaluated = 0;
+   auto count = [&](int value) { ++evaluated; return value; };
+   CHECK_EQ(count(1), count(1)) << "should never appear";
+   CHECK_NE(count(1), 2);
+   CHECK_LT(count(1), 2);
+   CHECK_LE(2, count(2));
+   CHECK_GT(count(3), 2);
+   CHECK_GE(count(3), 3);
+   logger.reset();
+   EXPECT_FALSE(mockFatalWasCalled());
+   EXPECT_EQ(7, evaluated);
+
+   std::string file_content = readFileToText(logger.logFile());
+   EXPECT_FALSE(verifyContent(file_content, "should never appear"));
+}
+
 TEST(CHECK, CHECK_runtimeError) {
    RestoreFileLogger logger(log_directory);
 
@@ -870,6 +1691,117 @@ TEST(DynamicLogging, DynamicLogging_Check_WillAlsoBeTurnedOffWhen_Fatal_Is_Disab
 }
 
 
+TEST(DynamicLogging, DynamicLogging_LevelOutsideTheTable_CanBeAddedAndRemoved) {
+   RestoreFileLogger logger(log_directory);
+   RestoreDynamicLoggingLevels raiiLevelRestore;
+   const LEVELS BIG {100000, {"BIG_LEVEL"}};
+   const LEVELS NEGATIVE {-5, {"NEGATIVE_LEVEL"}};
+   EXPECT_FALSE(g3::logLevel(BIG));
+   EXPECT_FALSE(g3::logLevel(NEGATIVE));
+
+   g3::only_change_at_initialization::addLogLevel(BIG, true);
+   g3::only_change_at_initialization::addLogLevel(NEGATIVE, true);
+   EXPECT_TRUE(g3::logLevel(BIG));
+   EXPECT_TRUE(g3::logLevel(NEGATIVE));
+   EXPECT_TRUE(g3::log_levels::getStatus(BIG) == g3::log_levels::status::Enabled);
+
+   LOG(BIG) << "big level message";
+   auto content = logger.resetAndRetrieveContent();
+   EXPECT_TRUE(verifyContent(content, "big level message")) << content;
+
+   g3::log_levels::disable(BIG);
+   EXPECT_FALSE(g3::logLevel(BIG));
+   EXPECT_TRUE(g3::log_levels::getStatus(BIG) == g3::log_levels::status::Disabled);
+   g3::only_change_at_initialization::reset();
+   EXPECT_FALSE(g3::logLevel(BIG));
+   EXPECT_FALSE(g3::logLevel(NEGATIVE));
+   EXPECT_TRUE(g3::log_levels::getStatus(BIG) == g3::log_levels::status::Absent);
+}
+
+
+TEST(DynamicLogging, DynamicLogging_ChangeLevelsWhileOtherThreadsLog) {
+   RestoreFileLogger logger(log_directory);
+   RestoreDynamicLoggingLevels raiiLevelRestore;
+   std::atomic<bool> done {false};
+   std::atomic<size_t> seen_enabled {0};
+   std::vector<std::thread> loggers;
+   for (int i = 0; i < 4; ++i) {
+      loggers.emplace_back([&] {
+         // also after 'done': the levels are all enabled again by then
+         for (int iterations = 0; !done.load() || iterations < 1000; ++iterations) {
+            if (g3::logLevel(G3LOG_DEBUG)) {
+               ++seen_enabled;
+            }
+            LOG(G3LOG_DEBUG) << "toggled level";
+         }
+      });
+   }
+
+   for (int i = 0; i < 1000; ++i) {
+      g3::log_levels::setHighest(INFO);
+      g3::log_levels::enableAll();
+   }
+   done = true;
+   for (auto& thread : loggers) {
+      thread.join();
+   }
+   EXPECT_TRUE(g3::logLevel(G3LOG_DEBUG));
+   EXPECT_GT(seen_enabled.load(), size_t{0});
+}
+
+TEST(DynamicLogging, DynamicLogging_ScopedThreadLevel_OnlyForTheCallingThread) {
+   RestoreDynamicLoggingLevels raiiLevelRestore;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      g3::log_levels::disable(G3LOG_DEBUG);
+      {
+         g3::ScopedThreadLevel trace(G3LOG_DEBUG);
+         EXPECT_TRUE(g3::logLevel(G3LOG_DEBUG));
+         LOG(G3LOG_DEBUG) << "traced thread;";
+         std::thread other([] {
+            EXPECT_FALSE(g3::logLevel(G3LOG_DEBUG));
+            LOG(G3LOG_DEBUG) << "other thread;";
+         });
+         other.join();
+         {
+            g3::ScopedThreadLevel quiet(WARNING);
+            LOG(INFO) << "quieted;";
+         }
+         LOG(INFO) << "restored to the outer guard;";
+      }
+      EXPECT_FALSE(g3::logLevel(G3LOG_DEBUG));
+      LOG(G3LOG_DEBUG) << "after the guard;";
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_TRUE(verifyContent(file_content, "traced thread;"));
+   EXPECT_FALSE(verifyContent(file_content, "other thread;"));
+   EXPECT_FALSE(verifyContent(file_content, "quieted;"));
+   EXPECT_TRUE(verifyContent(file_content, "restored to the outer guard;"));
+   EXPECT_FALSE(verifyContent(file_content, "after the guard;"));
+}
+
+#ifdef G3_LOG_VMODULE
+TEST(DynamicLogging, DynamicLogging_VModuleRuleEnablesALevelThatIsDisabled) {
+   RestoreVModule restoreRules;
+   RestoreDynamicLoggingLevels raiiLevelRestore;
+   std::string file_content;
+   {
+      RestoreFileLogger logger(log_directory);
+      g3::log_levels::disable(G3LOG_DEBUG);
+      LOG(G3LOG_DEBUG) << "debug disabled;";
+      ASSERT_TRUE(g3::setVModule("test_io.cpp=DEBUG"));
+      LOG(G3LOG_DEBUG) << "debug by the rule;";
+      logger.reset(); // force flush of logger
+      file_content = readFileToText(logger.logFile());
+   }
+   EXPECT_FALSE(verifyContent(file_content, "debug disabled;"));
+   EXPECT_TRUE(verifyContent(file_content, "debug by the rule;"));
+}
+#endif
+
+
 
 
 #else
@@ -15,6 +15,8 @@
 #include <g3log/generated_definitions.hpp>
 #include <testing_helpers.h>
 #include <g3log/filesink.hpp>
+#include <g3log/logmessagepool.hpp>
+#include <g3log/clock.hpp>
 namespace {
    // https://www.epochconverter.com/
    // epoc value for: Thu, 27 Apr 2017 06:22:49 GMT
@@ -75,9 +77,10 @@ TEST(Message, UseLogCall_4_DetailsWithThreadID_toString) {
    std::cout << kFile << std::endl;
    std::cout << output << std::endl;
 
-   std::ostringstream thread_id_oss;
-   thread_id_oss << std::this_thread::get_id();
-   EXPECT_TRUE(testing_helpers::verifyContent(output, thread_id_oss.str()));
+   // the operating system's thread id, e.g. gettid() on Linux
+   const std::string thread_id = std::to_string(g3::internal::currentThreadInfo().id);
+   EXPECT_EQ(thread_id, msg.threadID());
+   EXPECT_TRUE(testing_helpers::verifyContent(output, " " + thread_id + " "));
    EXPECT_FALSE(testing_helpers::verifyContent(output, kFile));
    EXPECT_TRUE(testing_helpers::verifyContent(output, kLevel.text));
    EXPECT_TRUE(testing_helpers::verifyContent(output, kFunction));
@@ -87,6 +90,129 @@ TEST(Message, UseLogCall_4_DetailsWithThreadID_toString) {
 
 
 
+TEST(Message, ThreadNameIsInTheFullDetails) {
+   using namespace g3;
+   std::string output;
+   std::string thread_id;
+   std::thread named([&] {
+      setThreadName("worker-thread-with-a-long-name");
+      EXPECT_EQ("worker-thread-with-a-long-name", threadName());
+      LogMessage msg{kFile, kLine, kFunction, kLevel};
+      EXPECT_EQ("worker-thread-with-a-long-name", msg.threadName());
+      thread_id = msg.threadID();
+      output = LogMessage::FullLogDetailsToString(msg);
+   });
+   named.join();
+
+   EXPECT_NE(std::to_string(internal::currentThreadInfo().id), thread_id);
+   EXPECT_TRUE(testing_helpers::verifyContent(output, " " + thread_id + "(worker-thread-with-a-long-name) ")) << output;
+   EXPECT_TRUE(testing_helpers::verifyContent(output, std::string(kFunction) + ":" + std::to_string(kLine) + "] ")) << output;
+
+   LogMessage unnamed{kFile, kLine, kFunction, kLevel};
+   EXPECT_TRUE(unnamed.threadName().empty());
+}
+
+
+TEST(Message, ScopedContextIsSharedWithTheMessage) {
+   using namespace g3;
+   LogMessage before{kFile, kLine, kFunction, kLevel};
+   EXPECT_EQ(nullptr, before._context);
+   EXPECT_EQ(nullptr, currentContext());
+   {
+      const int request = 42;
+      ScopedContext outer{{"req", request}, {"tenant", "acme"}};
+      LogMessage first{kFile, kLine, kFunction, kLevel};
+      LogMessage second{kFile, kLine, kFunction, kLevel};
+      EXPECT_EQ(first._context, second._context); // the same snapshot, not a copy
+      EXPECT_EQ("req=42 tenant=acme", first.context());
+      {
+         ScopedContext inner{{"shard", 7}};
+         LogMessage nested{kFile, kLine, kFunction, kLevel};
+         EXPECT_EQ("req=42 tenant=acme shard=7", nested.context());
+         ASSERT_EQ(3u, nested._context->fields().size());
+         EXPECT_EQ("shard", nested._context->fields()[2].key);
+         EXPECT_TRUE(testing_helpers::verifyContent(LogMessage::DefaultLogDetailsToString(nested), "] {req=42 tenant=acme shard=7} "));
+         EXPECT_TRUE(testing_helpers::verifyContent(LogMessage::FullLogDetailsToString(nested), "] {req=42 tenant=acme shard=7} "));
+
+         // the work for the request is done in another thread
+         std::string other_thread;
+         std::thread worker([context = currentContext(), &other_thread] {
+            ScopedContext adopted{context};
+            other_thread = LogMessage{kFile, kLine, kFunction, kLevel}.context();
+         });
+         worker.join();
+         EXPECT_EQ("req=42 tenant=acme shard=7", other_thread);
+      }
+      LogMessage copy{first};
+      EXPECT_EQ("req=42 tenant=acme", copy.context());
+      LogMessage later{kFile, kLine, kFunction, kLevel};
+      EXPECT_EQ("req=42 tenant=acme", later.context());
+   }
+   LogMessage after{kFile, kLine, kFunction, kLevel};
+   EXPECT_TRUE(after.context().empty());
+   EXPECT_FALSE(testing_helpers::verifyContent(LogMessage::DefaultLogDetailsToString(after), "{"));
+}
+
+
+TEST(Message, TypedFieldsAreReadBackWithTheirType) {
+   using namespace g3;
+   enum class Color { Red = 2 };
+   const std::string path = "/index.html";
+   LogMessage msg{kFile, kLine, kFunction, kLevel};
+   EXPECT_TRUE(msg.fields().empty());
+   for (const auto& field : {kv("latency_us", -123), kv("bytes", uint64_t{18446744073709551615ull}),
+                             kv("ratio", 0.25), kv("hit", true), kv("path", path), kv("color", Color::Red),
+                             kv("none", static_cast<const char*>(nullptr))}) {
+      internal::appendField(msg._fields, field);
+   }
+
+   std::vector<LogField> fields(msg.fields().begin(), msg.fields().end());
+   ASSERT_EQ(7u, fields.size());
+   EXPECT_EQ("latency_us", fields[0].key);
+   EXPECT_TRUE(LogField::Type::Int == fields[0].type);
+   EXPECT_EQ(-123, fields[0].integer);
+   EXPECT_TRUE(LogField::Type::UInt == fields[1].type);
+   EXPECT_EQ(18446744073709551615ull, fields[1].unsigned_integer);
+   EXPECT_TRUE(LogField::Type::Double == fields[2].type);
+   EXPECT_EQ(0.25, fields[2].floating);
+   EXPECT_TRUE(LogField::Type::Bool == fields[3].type);
+   EXPECT_TRUE(fields[3].boolean);
+   EXPECT_TRUE(LogField::Type::String == fields[4].type);
+   EXPECT_EQ(path, fields[4].text);
+   EXPECT_EQ(2, fields[5].integer);
+   EXPECT_EQ("", fields[6].text);
+   EXPECT_EQ("latency_us=-123 bytes=18446744073709551615 ratio=0.25 hit=true path=/index.html color=2 none=",
+             msg.fields().toString());
+
+   LogMessage copy{msg};
+   EXPECT_EQ(msg.fields().toString(), copy.fields().toString());
+   EXPECT_TRUE(testing_helpers::verifyContent(copy.toString(), "] " + copy.message() + " latency_us=-123 bytes="));
+
+   // a broken record ends the fields, it is not read past
+   copy._fields.resize(copy._fields.size() - 3);
+   EXPECT_EQ(6u, static_cast<size_t>(std::distance(copy.fields().begin(), copy.fields().end())));
+}
+
+
+TEST(Message, LazyCallableIsCalledOnceForAllCopies) {
+   using namespace g3;
+   int calls = 0;
+   LogMessage msg{kFile, kLine, kFunction, kLevel};
+   msg.write().append("text ");
+   msg._lazy = std::make_shared<internal::LazyTextOf<std::function<std::string()>>>([&calls] {
+      ++calls;
+      return std::string("lazy");
+   });
+   LogMessage copy{msg};
+   LogMessage moved{std::move(copy)};
+   EXPECT_EQ(0, calls);
+   EXPECT_EQ("text lazy", msg.message());
+   EXPECT_EQ("text lazy", moved.message());
+   EXPECT_EQ(1, calls);
+   EXPECT_EQ(nullptr, msg._lazy);
+}
+
+
 TEST(Message, DefaultFormattingToLogFile) {
    using namespace g3;
    std::string file_content;
@@ -141,6 +267,269 @@ TEST(Message, FullFormattingToLogFile) {
 
 
 
+TEST(Message, DetailsSurviveCopyMoveAndSwap) {
+   using namespace g3;
+   // short strings are kept in the small string buffer, which moves with the object
+   for (const auto& file : {std::string("a/b.cpp"), kFile + std::string(100, 'x') + "/long.cpp"}) {
+      LogMessage original{file.c_str(), kLine, kFunction.c_str(), kLevel, "x == y", "hello", LogMessage::Details::Copy};
+      const std::string expected_file = original.file();
+      EXPECT_EQ(file, original.file_path());
+      EXPECT_EQ(kFunction, original.function());
+      EXPECT_EQ("x == y", original.expression());
+      EXPECT_EQ("hello", original.message());
+
+      LogMessage copy{original};
+      LogMessage moved{std::move(copy)};
+      LogMessage other{"other.cpp", 1, "other", WARNING, "", "other message", LogMessage::Details::Copy};
+      swap(moved, other);
+      other.setExpression("y != z");
+
+      EXPECT_EQ(file, other.file_path());
+      EXPECT_EQ(expected_file, other.file());
+      EXPECT_EQ(kFunction, other.function());
+      EXPECT_EQ("y != z", other.expression());
+      EXPECT_EQ("hello", other.message());
+      EXPECT_EQ("other.cpp", moved.file());
+      EXPECT_EQ("other", moved.function());
+      EXPECT_EQ("", moved.expression());
+   }
+}
+
+TEST(Message, DetailsByReferenceAreNotCopied) {
+   using namespace g3;
+   const char* file = "dir/reference.cpp";
+   const char* function = "Reference::Call";
+   LogMessage msg{file, kLine, function, kLevel, "", "text", LogMessage::Details::Reference};
+   LogMessage copy{msg};
+   EXPECT_EQ(file, copy._file_path.data());
+   EXPECT_EQ(function, copy._function.data());
+   EXPECT_EQ("text", copy.message());
+#if !defined(G3_LOG_FULL_FILENAME)
+   EXPECT_EQ("reference.cpp", copy.file());
+#endif
+}
+
+
+TEST(Message, CallSiteInTheExecutableIsReferred) {
+   using namespace g3;
+   static const CallSite site{"some/dir/callsite.cpp", "void Some::function()", 42};
+   static_assert(internal::baseName("a/b\\c.cpp") == "c.cpp", "file name is found at compile time");
+#if !defined(G3_LOG_FULL_FILENAME)
+   EXPECT_EQ("callsite.cpp", site.file);
+#endif
+   EXPECT_TRUE(site.referable());
+
+   LogMessage msg{site, kLevel, "", "text"};
+   EXPECT_EQ(site.file_path.data(), msg._file_path.data());
+   EXPECT_EQ(site.function.data(), msg._function.data());
+   EXPECT_EQ(site.file, msg.file());
+   EXPECT_EQ("Some::function", msg.short_function());
+   EXPECT_EQ("42", msg.line());
+   EXPECT_EQ("text", msg.message());
+   EXPECT_TRUE(msg._details.empty());
+
+   int on_the_stack = 0;
+   EXPECT_FALSE(internal::isInExecutable(&on_the_stack));
+}
+
+
+TEST(Message, ShortFunctionName) {
+   using g3::internal::shortFunctionName;
+   static_assert(shortFunctionName("virtual void LogTest_LOG_Test::TestBody()") == "LogTest_LOG_Test::TestBody", "");
+   static_assert(shortFunctionName("int ns::inner::Class<int, char>::method(const std::string&) const") == "Class<int, char>::method", "");
+   static_assert(shortFunctionName("T ns::f(T) [with T = int]") == "ns::f", "");
+   static_assert(shortFunctionName("int main()") == "main", "");
+   static_assert(shortFunctionName("bool Foo::operator>(const Foo&) const") == "Foo::operator>", "");
+   static_assert(shortFunctionName("std::ostream& operator<<(std::ostream&, const X&)") == "operator<<", "");
+   static_assert(shortFunctionName("main()::<lambda()>") == "main()::<lambda()>", "");
+   static_assert(shortFunctionName("Foo::method") == "Foo::method", "");
+
+   // also when the message copies the details
+   g3::LogMessage msg{kFile.c_str(), kLine, "std::vector<int> ns::Foo::get() const", kLevel, "", "", g3::LogMessage::Details::Copy};
+   g3::LogMessage copy{msg};
+   EXPECT_EQ("Foo::get", copy.short_function());
+}
+
+
+TEST(Message, PooledMessageIsRecycled) {
+   using namespace g3;
+   static const CallSite site{"some/dir/pool.cpp", "void Pool::function()", 7};
+   const std::string long_text(1000, 'x');
+   const auto before = logMessagePoolStats();
+
+   auto message = internal::acquireLogMessage();
+   message->reuse(site, kLevel, "", long_text);
+   EXPECT_EQ(long_text, message->message());
+   EXPECT_EQ("Pool::function", message->short_function());
+   const LogMessage* first = message.get();
+   internal::releaseLogMessage(std::move(message));
+
+   // the same thread gets the same message back, with its memory
+   auto again = internal::acquireLogMessage();
+   EXPECT_EQ(first, again.get());
+   EXPECT_LE(long_text.size(), again->_message.capacity());
+   EXPECT_TRUE(again->message().empty());
+   again->reuse("other/file.cpp", 8, "Other::call", kLevel, "x > 0", "short", LogMessage::Details::Copy);
+   EXPECT_EQ("short", again->message());
+#if !defined(G3_LOG_FULL_FILENAME)
+   EXPECT_EQ("file.cpp", again->file());
+#endif
+   EXPECT_EQ("Other::call", again->function());
+   EXPECT_EQ("x > 0", again->expression());
+   EXPECT_EQ("8", again->line());
+   internal::releaseLogMessage(std::move(again));
+
+   const auto after = logMessagePoolStats();
+   EXPECT_LE(before.hits + 1, after.hits);
+   EXPECT_LE(before.hits + before.misses + 2, after.hits + after.misses);
+   EXPECT_GE(after.misses, after.high_watermark);
+   EXPECT_LT(0.0, after.hitRate());
+   EXPECT_GE(1.0, after.hitRate());
+}
+
+TEST(Message, PoolHighWatermarkIsTheMostInUseAtOnce) {
+   using namespace g3;
+   const size_t kHeld = 256;
+   std::vector<std::unique_ptr<LogMessage>> held;
+   for (size_t index = 0; index < kHeld; ++index) {
+      held.push_back(internal::acquireLogMessage());
+   }
+   for (auto& message : held) {
+      internal::releaseLogMessage(std::move(message));
+   }
+   const auto after_burst = logMessagePoolStats();
+   // in use is counted in batches per thread, so allow for what is not yet added
+   EXPECT_LE(kHeld / 2, after_burst.high_watermark);
+
+   // one at a time, the most in use at once does not grow with the messages acquired
+   for (size_t index = 0; index < 4 * kHeld; ++index) {
+      auto message = internal::acquireLogMessage();
+      internal::releaseLogMessage(std::move(message));
+   }
+   const auto after = logMessagePoolStats();
+   EXPECT_EQ(after_burst.high_watermark, after.high_watermark);
+}
+
+TEST(Message, SinkGivesPooledMessageBack) {
+   using namespace g3;
+   auto pooled = internal::acquireLogMessage();
+   pooled->reuse("file.cpp", kLine, "function", kLevel, "", "to the sinks", LogMessage::Details::Copy);
+   const LogMessage* address = pooled.get();
+
+   LogMessage copy("", 0, "", kLevel, "", "", LogMessage::Details::Reference);
+   copy.reuse(*pooled);
+   EXPECT_EQ("to the sinks", copy.message());
+   EXPECT_EQ("function", copy.function());
+
+   {
+      LogMessageMover mover(LogMessageMover::Owner(pooled.release(), internal::LogMessageDeleter {true}));
+      LogMessageMover sent = mover; // as when captured for the sink's thread, the copy takes it along
+      EXPECT_EQ(nullptr, mover._move_only);
+      EXPECT_EQ(address, &sent.get());
+      EXPECT_EQ("to the sinks", sent.get().message());
+   } // the sink is done with it
+
+   auto again = internal::acquireLogMessage();
+   EXPECT_EQ(address, again.get());
+   EXPECT_TRUE(again->message().empty());
+   internal::releaseLogMessage(std::move(again));
+
+   // a message that is not from the pool is deleted as usual
+   LogMessageMover plain(LogMessage("file.cpp", kLine, "function", kLevel, "", "plain", LogMessage::Details::Copy));
+   EXPECT_EQ("plain", plain.get().message());
+   LogMessage released = plain.release();
+   EXPECT_EQ("plain", released.message());
+}
+
+TEST(Message, ShortTextIsKeptInline) {
+   using namespace g3;
+   const std::string short_text(MessageBuffer::kInlineSize - 1, 's');
+   const std::string long_text(MessageBuffer::kInlineSize, 'l');
+
+   LogMessage msg{"file.cpp", kLine, "function", kLevel, "", short_text, LogMessage::Details::Copy};
+   EXPECT_TRUE(msg.buffer().isInline());
+   EXPECT_EQ(short_text, msg.message());
+
+   // spills to the heap when appended to
+   msg.buffer().append("+").append(std::string("++"));
+   EXPECT_FALSE(msg.buffer().isInline());
+   EXPECT_EQ(short_text + "+++", msg.message());
+
+   LogMessage copy{msg};
+   EXPECT_EQ(short_text + "+++", copy.message());
+   LogMessage moved{std::move(copy)};
+   EXPECT_EQ(short_text + "+++", moved.message());
+   EXPECT_TRUE(copy.message().empty());
+
+   LogMessage long_msg{"file.cpp", kLine, "function", kLevel, "", long_text, LogMessage::Details::Copy};
+   EXPECT_FALSE(long_msg.buffer().isInline());
+   LogMessage short_msg{"file.cpp", kLine, "function", kLevel, "", "short", LogMessage::Details::Copy};
+   swap(long_msg, short_msg);
+   EXPECT_EQ("short", long_msg.message());
+   EXPECT_EQ(long_text, short_msg.message());
+   EXPECT_TRUE(long_msg.buffer().isInline());
+
+   MessageBuffer buffer{long_text};
+   buffer.clear();
+   EXPECT_FALSE(buffer.isInline()) << "clear keeps the allocated memory";
+   buffer.shrink(MessageBuffer::kInlineSize);
+   EXPECT_TRUE(buffer.isInline());
+   EXPECT_TRUE(buffer.empty());
+   EXPECT_EQ(std::string(""), buffer.c_str());
+}
+
+
+TEST(Message, WriteIsAStdString) {
+   using namespace g3;
+   // whether a text is inline depends on G3_INLINE_MESSAGE_SIZE, see Options.cmake
+   auto fitsInline = [](const std::string& text) { return text.size() < MessageBuffer::kInlineSize; };
+   LogMessage msg{"file.cpp", kLine, "function", kLevel, "", "short text", LogMessage::Details::Copy};
+   EXPECT_EQ(fitsInline("short text"), msg.buffer().isInline());
+
+   // sinks keep on using the whole std::string API on write()
+   std::string& text = msg.write();
+   EXPECT_FALSE(msg.buffer().isInline());
+   text.insert(0, "a ");
+   EXPECT_EQ(2u, text.find("short"));
+   text.replace(text.find("text"), 4, "message");
+   text.erase(0, 2);
+   EXPECT_EQ("short", text.substr(0, 5));
+   text.resize(text.size() + 1, '!');
+   EXPECT_EQ("short message!", msg.message());
+   EXPECT_EQ(&text, &msg.write());
+
+   // the text appended to the buffer is in the same std::string
+   msg.buffer().append(" more");
+   EXPECT_EQ("short message! more", text);
+
+   LogMessage copy{msg};
+   EXPECT_EQ("short message! more", copy.message());
+   EXPECT_EQ(fitsInline(copy.message()), copy.buffer().isInline());
+   const LogMessage moved{std::move(msg)};
+   EXPECT_EQ("short message! more", moved.write());
+   EXPECT_TRUE(msg.message().empty());
+}
+
+
+TEST(Message, TimestampClocks) {
+   using namespace std::chrono;
+   auto near = [](auto first, auto second, milliseconds tolerance) {
+      const auto difference = (first > second) ? first - second : second - first;
+      return difference < tolerance;
+   };
+
+   EXPECT_TRUE(near(g3::internal::timestampNow(), high_resolution_clock::now(), milliseconds(50)));
+   EXPECT_TRUE(near(g3::internal::ticksToTimePoint(g3::internal::cpuTicks()), high_resolution_clock::now(), milliseconds(50)));
+   EXPECT_TRUE(near(g3::to_system_time(high_resolution_clock::now()), system_clock::now(), milliseconds(50)));
+
+   // the LogWorker converts the time stamp, or the message when it is asked for it
+   g3::LogMessage msg{"file.cpp", kLine, "function", kLevel, "", "text", g3::LogMessage::Details::Copy};
+   msg.materialize();
+   EXPECT_EQ(0u, msg._ticks);
+   EXPECT_TRUE(near(msg._timestamp, high_resolution_clock::now(), milliseconds(50)));
+}
+
+
 TEST(Message, CppSupport) {
    // ref: http://www.cplusplus.com/reference/clibrary/ctime/strftime/
    // ref: http://en.cppreference.com/w/cpp/io/manip/put_time